@@ -1,5 +1,6 @@
 #include "box2d/box2d.h"
 #include "SFML/Graphics.hpp"
+#include "Log.h"
 
 const static float kScaleFactor = 64.f;
 static sf::Vector2f b2s(const b2Vec2& b)
@@ -76,8 +77,7 @@ int main()
         }
         ourWorld.Step(kDeltaTime, kVelIters, kPosIters);
         b2Vec2 pos = boxBody->GetPosition();
-        float angle = boxBody->GetAngle();
-        printf("%.3f %.3f %.3f\n", pos.x, pos.y, angle);
+        LOG_DEBUG("%.3f %.3f %.3f\n", pos.x, pos.y, boxBody->GetAngle());
         sf::Vector2f viewPos = b2s(pos, ourWinSize, bSize);
         boxView.setPosition(viewPos);
 
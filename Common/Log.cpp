@@ -0,0 +1,251 @@
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LogDetail
+{
+    // Bytes of each thread's ring, a power of two
+    static const size_t kRingBytes = 1 << 16;
+    // Records start on this boundary, so the space left before the end of the ring always fits a header
+    static const size_t kGranule = 32;
+    // Sleep of the logging thread once the rings are empty
+    static const int kIdleMilliseconds = 2;
+
+    struct Header
+    {
+        uint32_t size; // Whole record, header included, a multiple of kGranule
+        int32_t level;
+        int64_t microseconds;
+        const char* format;
+        Replay replay; // nullptr for the padding up to the end of the ring
+    };
+    static_assert(sizeof(Header) <= kGranule, "the header has to fit a granule");
+
+    /// <summary>
+    /// Single producer, single consumer byte ring. Only the owning thread writes records and only the
+    /// logging thread reads them, the two positions are the only shared state.
+    /// </summary>
+    struct Ring
+    {
+        std::atomic<uint64_t> head{ 0 };
+        std::atomic<uint64_t> tail{ 0 };
+        std::atomic<uint64_t> numDropped{ 0 };
+        // Set once the owning thread has exited, the logging thread frees the ring after its last records
+        std::atomic<bool> isClosed{ false };
+        // Producer side, where the record being written ends
+        uint64_t pendingHead = 0;
+        // Consumer side, drops already reported
+        uint64_t numReported = 0;
+        unsigned thread = 0;
+        char data[kRingBytes];
+    };
+
+    class Logger
+    {
+    public:
+        Logger()
+            : myStart(std::chrono::steady_clock::now())
+            , myIsStopping(false)
+            , myThread(&Logger::run, this)
+        {
+        }
+
+        ~Logger()
+        {
+            myIsStopping = true;
+            myThread.join();
+            flush();
+        }
+
+        std::shared_ptr<Ring> addRing()
+        {
+            std::lock_guard<std::mutex> lock(myRingsMutex);
+            myRings.push_back(std::make_shared<Ring>());
+            myRings.back()->thread = myNumThreads++;
+            return myRings.back();
+        }
+
+        int64_t getMicroseconds() const
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - myStart).count();
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(myDrainMutex);
+            drain();
+        }
+
+    private:
+        void run()
+        {
+            while(!myIsStopping)
+            {
+                bool hasWritten;
+                {
+                    std::lock_guard<std::mutex> lock(myDrainMutex);
+                    hasWritten = drain();
+                }
+                if(!hasWritten)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(kIdleMilliseconds));
+            }
+        }
+
+        /// <summary>
+        /// Format everything queued, ring by ring, so each thread's messages keep their order
+        /// </summary>
+        bool drain()
+        {
+            std::vector<std::shared_ptr<Ring>> rings;
+            {
+                std::lock_guard<std::mutex> lock(myRingsMutex);
+                rings = myRings;
+            }
+            bool hasWritten = false;
+            std::vector<const Ring*> closedRings;
+            for(auto& ring : rings)
+            {
+                // Read before the head, so a closed ring has nothing committed after it
+                if(ring->isClosed.load(std::memory_order_acquire))
+                    closedRings.push_back(ring.get());
+                uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                const uint64_t head = ring->head.load(std::memory_order_acquire);
+                hasWritten |= tail != head;
+                while(tail != head)
+                {
+                    const char* record = &ring->data[tail & (kRingBytes - 1)];
+                    Header header;
+                    memcpy(&header, record, sizeof(Header));
+                    if(header.replay)
+                        write(*ring, header, record + kGranule);
+                    tail += header.size;
+                }
+                ring->tail.store(tail, std::memory_order_release);
+                const uint64_t numDropped = ring->numDropped.load(std::memory_order_relaxed);
+                if(numDropped != ring->numReported)
+                {
+                    fprintf(stderr, "warning: %llu log records dropped on thread %u\n",
+                            (unsigned long long)(numDropped - ring->numReported), ring->thread);
+                    ring->numReported = numDropped;
+                }
+            }
+            if(!closedRings.empty())
+            {
+                // Everything those rings held is written, let them go
+                std::lock_guard<std::mutex> lock(myRingsMutex);
+                myRings.erase(std::remove_if(myRings.begin(), myRings.end(), [&closedRings](const std::shared_ptr<Ring>& aRing)
+                                             { return closedRings.end() != std::find(closedRings.begin(), closedRings.end(), aRing.get()); }),
+                              myRings.end());
+            }
+            if(hasWritten)
+            {
+                fflush(stdout);
+                fflush(stderr);
+            }
+            return hasWritten;
+        }
+
+        static void write(const Ring& aRing, const Header& aHeader, const char* aPayload)
+        {
+            FILE* file = stdout;
+            switch((LogLevel)aHeader.level)
+            {
+            case LogLevel::Debug:
+                fprintf(file, "[%.3f t%u] ", aHeader.microseconds * 1e-6, aRing.thread);
+                break;
+            case LogLevel::Warning:
+                file = stderr;
+                fputs("warning: ", file);
+                break;
+            case LogLevel::Error:
+                file = stderr;
+                fputs("error: ", file);
+                break;
+            default:
+                break;
+            }
+            aHeader.replay(file, aHeader.format, aPayload);
+        }
+
+        std::chrono::steady_clock::time_point myStart;
+        std::mutex myRingsMutex;
+        std::vector<std::shared_ptr<Ring>> myRings;
+        unsigned myNumThreads = 0;
+        // One drain at a time, the logging thread's or a flush
+        std::mutex myDrainMutex;
+        std::atomic<bool> myIsStopping;
+        std::thread myThread;
+    };
+
+    static Logger& getLogger()
+    {
+        static Logger ourLogger;
+        return ourLogger;
+    }
+
+    /// <summary>
+    /// Marks the calling thread's ring closed when the thread exits
+    /// </summary>
+    struct RingOwner
+    {
+        std::shared_ptr<Ring> ring;
+        ~RingOwner() { ring->isClosed.store(true, std::memory_order_release); }
+    };
+
+    static Ring& getRing()
+    {
+        static thread_local RingOwner ourOwner{ getLogger().addRing() };
+        return *ourOwner.ring;
+    }
+
+    char* beginRecord(LogLevel aLevel, const char* aFormat, Replay aReplay, size_t aSize)
+    {
+        Ring& ring = getRing();
+        const size_t size = (kGranule + aSize + kGranule - 1) / kGranule * kGranule;
+        if(size > kRingBytes / 2)
+        {
+            ring.numDropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        const size_t toEnd = kRingBytes - (head & (kRingBytes - 1));
+        const size_t needed = toEnd < size ? toEnd + size : size;
+        while(kRingBytes - (head - ring.tail.load(std::memory_order_acquire)) < needed)
+        {
+            // Debug traces are the hot path and give way, anything else waits for the logging thread
+            if(LogLevel::Debug == aLevel)
+            {
+                ring.numDropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+        if(toEnd < size)
+        {
+            Header padding = { (uint32_t)toEnd, 0, 0, nullptr, nullptr };
+            memcpy(&ring.data[head & (kRingBytes - 1)], &padding, sizeof(Header));
+            head += toEnd;
+        }
+        Header header = { (uint32_t)size, (int32_t)aLevel, getLogger().getMicroseconds(), aFormat, aReplay };
+        char* record = &ring.data[head & (kRingBytes - 1)];
+        memcpy(record, &header, sizeof(Header));
+        ring.pendingHead = head + size;
+        return record + kGranule;
+    }
+
+    void commitRecord()
+    {
+        Ring& ring = getRing();
+        ring.head.store(ring.pendingHead, std::memory_order_release);
+    }
+}
+
+void logFlush()
+{
+    LogDetail::getLogger().flush();
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Levels, numbers so the preprocessor can compare them
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// Calls below this level compile to nothing, arguments included
+#ifndef LOG_LEVEL
+#ifdef _DEBUG
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+enum class LogLevel
+{
+    Debug = LOG_LEVEL_DEBUG, // Per frame and per event traces
+    Info = LOG_LEVEL_INFO, // Results and user visible changes
+    Warning = LOG_LEVEL_WARNING,
+    Error = LOG_LEVEL_ERROR
+};
+
+namespace LogDetail
+{
+    /// <summary>
+    /// How an argument travels through the ring: copied as is, strings copied with their terminator
+    /// </summary>
+    template<typename T, typename Enable = void>
+    struct Arg
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value,
+                      "log arguments are copied raw, pass strings as const char*");
+        static size_t size(T) { return sizeof(T); }
+        static char* write(char* aCursor, T aValue)
+        {
+            memcpy(aCursor, &aValue, sizeof(T));
+            return aCursor + sizeof(T);
+        }
+        static T read(const char*& ioCursor)
+        {
+            T value;
+            memcpy(&value, ioCursor, sizeof(T));
+            ioCursor += sizeof(T);
+            return value;
+        }
+    };
+
+    template<typename T>
+    struct Arg<T, typename std::enable_if<std::is_same<T, const char*>::value || std::is_same<T, char*>::value>::type>
+    {
+        static size_t size(const char* aText) { return strlen(aText) + 1; }
+        static char* write(char* aCursor, const char* aText)
+        {
+            size_t length = strlen(aText) + 1;
+            memcpy(aCursor, aText, length);
+            return aCursor + length;
+        }
+        static const char* read(const char*& ioCursor)
+        {
+            const char* text = ioCursor;
+            ioCursor += strlen(text) + 1;
+            return text;
+        }
+    };
+
+    template<typename T>
+    using Stored = typename std::decay<T>::type;
+
+    // Runs on the logging thread, decodes the arguments and formats
+    typedef void (*Replay)(FILE* aFile, const char* aFormat, const char* aPayload);
+
+    template<typename... Args, size_t... Indices>
+    void replayTuple(FILE* aFile, const char* aFormat, const std::tuple<Args...>& someArgs, std::index_sequence<Indices...>)
+    {
+        fprintf(aFile, aFormat, std::get<Indices>(someArgs)...);
+    }
+
+    template<typename... Args>
+    void replay(FILE* aFile, const char* aFormat, const char* aPayload)
+    {
+        const char* cursor = aPayload;
+        // Braced initialisation reads the arguments left to right
+        std::tuple<decltype(Arg<Args>::read(cursor))...> args{ Arg<Args>::read(cursor)... };
+        (void)cursor;
+        replayTuple(aFile, aFormat, args, std::index_sequence_for<Args...>());
+    }
+
+    /// <summary>
+    /// Reserve aSize payload bytes in the calling thread's ring, nullptr when it is full and the record is dropped
+    /// </summary>
+    char* beginRecord(LogLevel aLevel, const char* aFormat, Replay aReplay, size_t aSize);
+    void commitRecord();
+
+    inline size_t sum() { return 0; }
+    template<typename... Sizes>
+    size_t sum(size_t aFirst, Sizes... someRest) { return aFirst + sum(someRest...); }
+
+    inline char* writeAll(char* aCursor) { return aCursor; }
+    template<typename T, typename... Rest>
+    char* writeAll(char* aCursor, const T& aValue, const Rest&... someRest)
+    {
+        return writeAll(Arg<Stored<T>>::write(aCursor, aValue), someRest...);
+    }
+}
+
+/// <summary>
+/// Queue a printf style message. The arguments are copied into a lock free ring owned by the calling thread
+/// and formatted later on the logging thread, so the caller never waits on the console or a pipe.
+/// The format has to outlive the program, a string literal. Records are dropped, and counted, while the ring is full.
+/// </summary>
+template<typename... Args>
+void logWrite(LogLevel aLevel, const char* aFormat, const Args&... someArgs)
+{
+    const size_t size = LogDetail::sum(LogDetail::Arg<LogDetail::Stored<Args>>::size(someArgs)...);
+    char* payload = LogDetail::beginRecord(aLevel, aFormat, &LogDetail::replay<LogDetail::Stored<Args>...>, size);
+    if(!payload)
+        return;
+    LogDetail::writeAll(payload, someArgs...);
+    LogDetail::commitRecord();
+}
+
+/// <summary>
+/// Block until everything queued so far, from every thread, is written out
+/// </summary>
+void logFlush();
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logWrite(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) logWrite(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) logWrite(LogLevel::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logWrite(LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
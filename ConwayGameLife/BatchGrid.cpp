@@ -0,0 +1,132 @@
+#include "BatchGrid.h"
+#include <algorithm>
+#include "BitOps.h"
+
+BatchGrid::BatchGrid(int aWidth, int aHeight)
+    : myWidth(aWidth)
+    , myHeight(aHeight)
+    , myCells((size_t)aWidth * aHeight, 0)
+    , myNextCells(myCells.size(), 0)
+{
+}
+
+void BatchGrid::load(int aLane, const BitGrid& aBoard)
+{
+    const uint64_t bit = 1ULL << aLane;
+    for(int y = 0; y < myHeight; y++)
+    {
+        uint64_t* row = &myCells[(size_t)y * myWidth];
+        for(int x = 0; x < myWidth; x++)
+            row[x] = aBoard.get(x, y) ? row[x] | bit : row[x] & ~bit;
+    }
+}
+
+void BatchGrid::save(int aLane, BitGrid& outBoard) const
+{
+    if(outBoard.getWidth() != myWidth || outBoard.getHeight() != myHeight)
+        outBoard.resize(myWidth, myHeight);
+    for(int y = 0; y < myHeight; y++)
+    {
+        const uint64_t* row = &myCells[(size_t)y * myWidth];
+        for(int x = 0; x < myWidth; x++)
+            outBoard.set(x, y, (row[x] >> aLane) & 1);
+    }
+}
+
+void BatchGrid::step(uint64_t anActiveLanes)
+{
+    const int width = myWidth;
+    for(int y = 0; y < myHeight; y++)
+    {
+        const uint64_t* above = &myCells[(size_t)(y == 0 ? myHeight - 1 : y - 1) * width];
+        const uint64_t* center = &myCells[(size_t)y * width];
+        const uint64_t* below = &myCells[(size_t)(y + 1 == myHeight ? 0 : y + 1) * width];
+        uint64_t* next = &myNextCells[(size_t)y * width];
+        auto stepCell = [&](int aWest, int x, int anEast)
+        {
+            uint64_t word = lifeWord(above[aWest], above[x], above[anEast],
+                                     center[aWest], center[x], center[anEast],
+                                     below[aWest], below[x], below[anEast]);
+            next[x] = (word & anActiveLanes) | (center[x] & ~anActiveLanes);
+        };
+        // The wrapping columns apart, the rest is plain bitwise work on contiguous words that compilers vectorise
+        stepCell(width - 1, 0, width > 1 ? 1 : 0);
+        for(int x = 1; x + 1 < width; x++)
+            stepCell(x - 1, x, x + 1);
+        if(width > 1)
+            stepCell(width - 2, width - 1, 0);
+    }
+    myCells.swap(myNextCells);
+}
+
+uint64_t BatchGrid::getEqualLanes(const BatchGrid& anOther) const
+{
+    uint64_t differences = 0;
+    for(size_t i = 0; i < myCells.size(); i++)
+        differences |= myCells[i] ^ anOther.myCells[i];
+    return ~differences;
+}
+
+void BatchGrid::copyLanes(const BatchGrid& aSource, uint64_t someLanes)
+{
+    for(size_t i = 0; i < myCells.size(); i++)
+        myCells[i] = (myCells[i] & ~someLanes) | (aSource.myCells[i] & someLanes);
+}
+
+void runBatch(const std::vector<BitGrid>& somePatterns, uint64_t aMaxGenerations, std::vector<BatchResult>& outResults)
+{
+    outResults.assign(somePatterns.size(), BatchResult());
+    if(somePatterns.empty())
+        return;
+    BatchGrid batch(somePatterns[0].getWidth(), somePatterns[0].getHeight());
+    BatchGrid checkpoint = batch;
+    // Per lane, the pattern it runs, its generation and Brent's power and steps since the checkpoint
+    size_t patterns[BatchGrid::kLanes];
+    uint64_t generations[BatchGrid::kLanes], powers[BatchGrid::kLanes], lambdas[BatchGrid::kLanes];
+    size_t nextPattern = 0;
+    uint64_t active = 0;
+    auto startLane = [&](int aLane)
+    {
+        if(nextPattern == somePatterns.size())
+            return;
+        patterns[aLane] = nextPattern;
+        generations[aLane] = 0;
+        powers[aLane] = 1;
+        lambdas[aLane] = 0;
+        batch.load(aLane, somePatterns[nextPattern++]);
+        active |= 1ULL << aLane;
+    };
+    for(int lane = 0; lane < BatchGrid::kLanes; lane++)
+        startLane(lane);
+    checkpoint.copyLanes(batch, active);
+    while(active)
+    {
+        batch.step(active);
+        const uint64_t repeated = batch.getEqualLanes(checkpoint) & active;
+        uint64_t moved = 0;
+        for(uint64_t lanes = active; lanes; lanes &= lanes - 1)
+        {
+            const int lane = ctz64(lanes);
+            const uint64_t bit = 1ULL << lane;
+            ++generations[lane];
+            const bool isStable = 0 != (repeated & bit);
+            if(isStable || generations[lane] == aMaxGenerations)
+            {
+                BatchResult& result = outResults[patterns[lane]];
+                result.generations = generations[lane];
+                result.isStable = isStable;
+                batch.save(lane, result.board);
+                active &= ~bit;
+                startLane(lane);
+                moved |= bit;
+            }
+            else if(++lambdas[lane] == powers[lane])
+            {
+                powers[lane] <<= 1;
+                lambdas[lane] = 0;
+                moved |= bit;
+            }
+        }
+        checkpoint.copyLanes(batch, moved);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "BitGrid.h"
+
+/// <summary>
+/// 64 independent torus boards of the same size in lockstep. Each cell is a word whose bit k belongs to board k,
+/// so one pass of the adder network steps every board, no shifting needed since neighbours are whole words.
+/// </summary>
+class BatchGrid
+{
+public:
+    static const int kLanes = 64;
+
+    BatchGrid(int aWidth, int aHeight);
+
+    int getWidth() const { return myWidth; }
+    int getHeight() const { return myHeight; }
+
+    /// <summary>
+    /// Copy a board in or out of lane aLane, boards have to match the batch size
+    /// </summary>
+    void load(int aLane, const BitGrid& aBoard);
+    void save(int aLane, BitGrid& outBoard) const;
+
+    /// <summary>
+    /// Advance the lanes set in anActiveLanes one generation, the others keep their state
+    /// </summary>
+    void step(uint64_t anActiveLanes = ~0ULL);
+
+    /// <summary>
+    /// Lanes whose board equals the same lane of anOther
+    /// </summary>
+    uint64_t getEqualLanes(const BatchGrid& anOther) const;
+    /// <summary>
+    /// Take the boards of the lanes set in someLanes from aSource
+    /// </summary>
+    void copyLanes(const BatchGrid& aSource, uint64_t someLanes);
+
+private:
+    int myWidth, myHeight;
+    std::vector<uint64_t> myCells;
+    std::vector<uint64_t> myNextCells;
+};
+
+/// <summary>
+/// Final state of a board run to stabilisation
+/// </summary>
+struct BatchResult
+{
+    BitGrid board;
+    uint64_t generations = 0; // When the repeat was seen, or the limit
+    bool isStable = false;
+};
+
+/// <summary>
+/// Run every pattern until it repeats or hits the limit, 64 at a time. Each lane runs Brent's cycle detection
+/// against its own checkpoint, moved every power of two generations, and the moment a lane is done
+/// it takes the next waiting pattern, so the batch never idles on its slowest board.
+/// </summary>
+/// <param name="somePatterns">Initial boards, all of the same size</param>
+/// <param name="outResults">One per pattern, in the same order</param>
+void runBatch(const std::vector<BitGrid>& somePatterns, uint64_t aMaxGenerations, std::vector<BatchResult>& outResults);
@@ -0,0 +1,177 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "BitGrid.h"
+#include "FixedGrid.h"
+#include "Harness.h"
+#include "LifeEngine.h"
+#include "LifeStats.h"
+#include "Log.h"
+#include "PerfCounters.h"
+#include "TileSet.h"
+
+// The tile set is only timed below this many live cells, it is far too slow beyond
+static const uint64_t kMaxTileSetPopulation = 200000;
+
+/// <summary>
+/// Run aStep aNumCalls times, counting around each call when profiling
+/// </summary>
+/// <returns>Seconds taken</returns>
+template<typename F>
+static double timeCalls(int aNumCalls, PerfCounters* ioCounters, F aStep)
+{
+    if(ioCounters)
+        ioCounters->reset();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < aNumCalls; i++)
+    {
+        if(ioCounters)
+            ioCounters->start();
+        aStep();
+        if(ioCounters)
+            ioCounters->stop();
+    }
+    return secondsSince(start);
+}
+
+static void printResult(const char* aName, int aSide, int aGenerations, double aSeconds, const PerfCounters* someCounters)
+{
+    const double numCells = (double)aSide * aSide * aGenerations;
+    LOG_INFO("%-24s %10.3f ms/gen %12.4g cells/s\n", aName, aSeconds * 1e3 / aGenerations, numCells / aSeconds);
+    if(!someCounters || !someCounters->isAvailable())
+        return;
+    PerfCounters::Sample sample;
+    someCounters->read(sample);
+    // Per cell per generation, what the counters could not measure shows as n/a
+    char line[256] = "";
+    int length = 0;
+    for(int i = 0; i < PerfCounters::NumCounters; i++)
+    {
+        if(sample.isValid[i])
+            length += snprintf(line + length, sizeof(line) - length, " %.4g %s,", sample.values[i] / numCells, PerfCounters::getName((PerfCounters::Counter)i));
+        else
+            length += snprintf(line + length, sizeof(line) - length, " n/a %s,", PerfCounters::getName((PerfCounters::Counter)i));
+    }
+    if(sample.isValid[PerfCounters::Cycles] && sample.isValid[PerfCounters::Instructions] && sample.values[PerfCounters::Cycles])
+        snprintf(line + length, sizeof(line) - length, " IPC %.2f", (double)sample.values[PerfCounters::Instructions] / sample.values[PerfCounters::Cycles]);
+    else if(length)
+        line[length - 1] = 0;
+    LOG_INFO("%-24s per cell/gen:%s\n", "", line);
+}
+
+/// <summary>
+/// The benchmark, with counters around every step call when ioCounters is set
+/// </summary>
+static int bench(int argc, char* argv[], PerfCounters* ioCounters)
+{
+    int side = argc > 0 ? atoi(argv[0]) : 1024;
+    int age = argc > 1 ? atoi(argv[1]) : 4000;
+    int generations = argc > 2 ? atoi(argv[2]) : 200;
+    int depth = argc > 3 ? atoi(argv[3]) : BitGrid::kBlockDepth;
+    if(side < 2 || side % 2 || age < 0 || generations < 1 || depth < 1)
+    {
+        LOG_INFO("usage: --bench [even side] [age] [generations] [block depth]\n");
+        return 1;
+    }
+    BitGrid soup(side, side);
+    soup.setSleeping(true);
+    std::mt19937_64 random(0);
+    for(int y = 0; y < side; y++)
+    {
+        uint64_t* row = soup.editRow(y);
+        for(int i = 0; i < soup.getWordsPerRow(); i++)
+            row[i] = random() & (i + 1 == soup.getWordsPerRow() ? soup.getTailMask() : ~0ULL);
+    }
+    for(int i = 0; i < age; i++)
+        soup.step();
+    LOG_INFO("%dx%d soup aged %d generations, population %llu, timing %d generations\n", side, side, age,
+           (unsigned long long)soup.getPopulation(), generations);
+
+    BitGrid reference(soup);
+    reference.setSleeping(false);
+    double seconds = timeCalls(generations, ioCounters, [&reference]() { reference.step(); });
+    printResult("dense bits", side, generations, seconds, ioCounters);
+
+    // Compiled in sizes only
+    std::unique_ptr<LifeEngine> fixed = createFixedEngine(side);
+    if(fixed)
+    {
+        std::vector<sf::Vector2i> cells, fixedCells;
+        for(int y = 0; y < side; y++)
+        {
+            for(int x = 0; x < side; x++)
+            {
+                if(soup.get(x, y))
+                    cells.push_back(sf::Vector2i(x, y));
+            }
+        }
+        fixed->load(cells);
+        seconds = timeCalls(generations, ioCounters, [&fixed]() { fixed->step(1); });
+        const std::string fixedName = "fixed grid " + std::to_string(side) + "x" + std::to_string(side);
+        printResult(fixedName.c_str(), side, generations, seconds, ioCounters);
+        fixed->save(fixedCells);
+        saveWords(reference.getRow(0), reference.getWordsPerRow(), side, cells);
+        if(fixedCells != cells)
+            LOG_ERROR("fixed grid MISMATCH\n");
+    }
+
+    BitGrid blocked(soup);
+    blocked.setSleeping(false);
+    seconds = timeCalls(1, ioCounters, [&blocked, generations, depth]() { blocked.stepBlocked(generations, depth); });
+    char name[32];
+    snprintf(name, sizeof(name), "dense bits, %d per pass", depth);
+    printResult(name, side, generations, seconds, ioCounters);
+    if(!(blocked == reference))
+        LOG_ERROR("blocked step MISMATCH\n");
+
+    BitGrid sleeping(soup);
+    sleeping.setSleeping(true);
+    seconds = timeCalls(generations, ioCounters, [&sleeping]() { sleeping.step(); });
+    printResult("dense bits, sleeping", side, generations, seconds, ioCounters);
+    LOG_INFO("%-24s %10.1f%% of %d tiles asleep%s\n", "", 100.0 * sleeping.getSleepingFraction(),
+           ((side + BitGrid::kTileRows - 1) / BitGrid::kTileRows) * soup.getWordsPerRow(),
+           sleeping == reference ? "" : ", MISMATCH");
+
+    if(soup.getPopulation() <= kMaxTileSetPopulation)
+    {
+        const int half = side / 2;
+        TileSet lastTiles, tiles;
+        for(int y = 0; y < side; y++)
+        {
+            for(int x = 0; x < side; x++)
+            {
+                if(soup.get(x, y))
+                    tiles.insert(sf::Vector2i(x - half, y - half));
+            }
+        }
+        const TileAllocationCounts before = getTileAllocationCounts();
+        seconds = timeCalls(generations, ioCounters, [&lastTiles, &tiles, half]() { processCore(lastTiles, tiles, nullptr, half); });
+        printResult("tile set", side, generations, seconds, ioCounters);
+        // Every node used to be its own heap allocation, the pools only go to the heap to grow
+        const TileAllocationCounts after = getTileAllocationCounts();
+        LOG_INFO("%-24s %10.0f nodes/gen %12.1f heap allocations/gen\n", "",
+                 (double)(after.nodes - before.nodes) / generations, (double)(after.heap - before.heap) / generations);
+    }
+    else
+    {
+        LOG_INFO("tile set skipped, population above %llu\n", (unsigned long long)kMaxTileSetPopulation);
+    }
+    return 0;
+}
+
+int runBenchmark(int argc, char* argv[])
+{
+    return bench(argc, argv, nullptr);
+}
+
+int runProfile(int argc, char* argv[])
+{
+    PerfCounters counters;
+    // Without counters this is still the plain benchmark
+    if(!counters.open())
+        LOG_WARNING("profiling without counters, timings only\n");
+    return bench(argc, argv, &counters);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+/// <summary>
+/// Command line entry, "--bench [side] [age] [generations] [block depth]".
+/// Ages a random soup on the dense engine, then times the same generations on the tile set,
+/// the dense bits one generation per pass, the compiled in fixed grid of that side if any,
+/// temporally blocked and with sleeping tiles.
+/// Sides past the last level cache (over 8192 or so) show what the blocking saves.
+/// </summary>
+int runBenchmark(int argc, char* argv[]);
+
+/// <summary>
+/// Command line entry, "--profile" and the same arguments. The benchmark with hardware counters around every
+/// step call, cycles, instructions, cache and branch misses per cell per generation where the system allows.
+/// </summary>
+int runProfile(int argc, char* argv[]);
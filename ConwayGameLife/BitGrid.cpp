@@ -0,0 +1,352 @@
+#include "BitGrid.h"
+#include <algorithm>
+#include "BitOps.h"
+#include "Changes.h"
+#include "LifeEngine.h"
+#include "LifeStats.h"
+
+// Quiet generations in a row before a tile goes to sleep
+static const uint8_t kSleepAfter = 4;
+// Target size of a band and its halo in the blocked step, to stay in L2
+static const size_t kBandBytes = 256 * 1024;
+
+BitGrid::BitGrid(int aWidth, int aHeight)
+    : myIsSleeping(false)
+    , mySleepingFraction(0.0)
+{
+    resize(aWidth, aHeight);
+}
+
+void BitGrid::resize(int aWidth, int aHeight)
+{
+    myWidth = aWidth;
+    myHeight = aHeight;
+    myWordsPerRow = (aWidth + 63) / 64;
+    myTailMask = (aWidth & 63) ? (1ULL << (aWidth & 63)) - 1 : ~0ULL;
+    myCells.assign((size_t)myWordsPerRow * aHeight, 0);
+    myNextCells.assign(myCells.size(), 0);
+    myTilesPerColumn = (aHeight + kTileRows - 1) / kTileRows;
+    myQuietCounts.assign((size_t)myTilesPerColumn * myWordsPerRow, 0);
+    myIsAwake.assign(myQuietCounts.size(), 1);
+    myIsAwakeNext.assign(myQuietCounts.size(), 1);
+    myIsHistoryValid = false;
+}
+
+void BitGrid::clear()
+{
+    std::fill(myCells.begin(), myCells.end(), 0);
+    myIsHistoryValid = false;
+}
+
+void BitGrid::setSleeping(bool isEnabled)
+{
+    myIsSleeping = isEnabled;
+    myIsHistoryValid = false;
+    mySleepingFraction = 0.0;
+}
+
+void BitGrid::set(int x, int y, bool isLive)
+{
+    myIsHistoryValid = false;
+    uint64_t& word = myCells[y * myWordsPerRow + (x >> 6)];
+    uint64_t bit = 1ULL << (x & 63);
+    word = isLive ? word | bit : word & ~bit;
+}
+
+/// <summary>
+/// Row shifted so that bit x holds cell x - 1, wrapping across the torus
+/// </summary>
+static inline uint64_t westOf(const uint64_t* aRow, int anIndex, int aWidth)
+{
+    uint64_t carry = anIndex > 0 ? aRow[anIndex - 1] >> 63
+                                 : (aRow[(aWidth - 1) >> 6] >> ((aWidth - 1) & 63)) & 1;
+    return (aRow[anIndex] << 1) | carry;
+}
+
+/// <summary>
+/// Row shifted so that bit x holds cell x + 1, wrapping across the torus
+/// </summary>
+static inline uint64_t eastOf(const uint64_t* aRow, int anIndex, int aWordsPerRow, int aWidth)
+{
+    uint64_t result = aRow[anIndex] >> 1;
+    if(anIndex + 1 < aWordsPerRow)
+        result |= aRow[anIndex + 1] << 63;
+    else
+        result |= (aRow[0] & 1) << ((aWidth - 1) & 63);
+    return result;
+}
+
+/// <summary>
+/// One generation of a row from the rows around it
+/// </summary>
+static void lifeRow(const uint64_t* anAbove, const uint64_t* aCenter, const uint64_t* aBelow, uint64_t* outRow,
+                    int aWordsPerRow, int aWidth, uint64_t aTailMask)
+{
+    for(int i = 0; i < aWordsPerRow; i++)
+    {
+        outRow[i] = lifeWord(westOf(anAbove, i, aWidth), anAbove[i], eastOf(anAbove, i, aWordsPerRow, aWidth),
+                             westOf(aCenter, i, aWidth), aCenter[i], eastOf(aCenter, i, aWordsPerRow, aWidth),
+                             westOf(aBelow, i, aWidth), aBelow[i], eastOf(aBelow, i, aWordsPerRow, aWidth));
+    }
+    outRow[aWordsPerRow - 1] &= aTailMask;
+}
+
+void BitGrid::wakeTile(int aTileY, int aTileX)
+{
+    aTileY = (aTileY + myTilesPerColumn) % myTilesPerColumn;
+    aTileX = (aTileX + myWordsPerRow) % myWordsPerRow;
+    myIsAwakeNext[aTileY * myWordsPerRow + aTileX] = 1;
+}
+
+/// <summary>
+/// Step with sleeping tiles. The scratch buffer holds the generation before the current one, so a tile whose
+/// next state matches it is still or period 2 and, once asleep, already has its next state in place.
+/// A tile may stay asleep while its neighbourhood repeats with period 2 as well, which every awake tile
+/// checks on its border cells as it writes them.
+/// </summary>
+void BitGrid::stepTiles(GenerationStats* outStats)
+{
+    const int numWords = myWordsPerRow;
+    std::vector<uint64_t> columnMask;
+    if(outStats)
+    {
+        outStats->reset();
+        columnMask.assign(numWords, 0);
+    }
+    // Per tile of the current tile row, changes against two generations back on each border and anywhere.
+    // The east column bit sits lower in the tail word.
+    std::vector<uint64_t> top(numWords), bottom(numWords), west(numWords), east(numWords), changed(numWords);
+    std::vector<uint8_t> isAwake(numWords);
+    const int tailEastBit = (myWidth - 1) & 63;
+    std::fill(myIsAwakeNext.begin(), myIsAwakeNext.end(), 0);
+    size_t numSleeping = 0;
+    for(int tileY = 0; tileY < myTilesPerColumn; tileY++)
+    {
+        const int firstY = tileY * kTileRows, lastY = std::min(myHeight, firstY + kTileRows) - 1;
+        const uint8_t* isTileAwake = &myIsAwake[(size_t)tileY * numWords];
+        bool isAnyAwake = false;
+        for(int i = 0; i < numWords; i++)
+        {
+            isAwake[i] = !myIsHistoryValid || isTileAwake[i];
+            isAnyAwake |= 0 != isAwake[i];
+            west[i] = east[i] = changed[i] = 0;
+        }
+        if(!isAnyAwake && !outStats)
+        {
+            numSleeping += numWords;
+            continue;
+        }
+        for(int y = firstY; y <= lastY; y++)
+        {
+            const uint64_t* above = &myCells[(size_t)(y == 0 ? myHeight - 1 : y - 1) * numWords];
+            const uint64_t* center = &myCells[(size_t)y * numWords];
+            const uint64_t* below = &myCells[(size_t)(y + 1 == myHeight ? 0 : y + 1) * numWords];
+            uint64_t* next = &myNextCells[(size_t)y * numWords];
+            uint64_t rowMask = 0;
+            for(int i = 0; i < numWords; i++)
+            {
+                // Asleep, the next state is already in place
+                if(isAwake[i])
+                {
+                    uint64_t word = lifeWord(westOf(above, i, myWidth), above[i], eastOf(above, i, numWords, myWidth),
+                                             westOf(center, i, myWidth), center[i], eastOf(center, i, numWords, myWidth),
+                                             westOf(below, i, myWidth), below[i], eastOf(below, i, numWords, myWidth));
+                    if(i + 1 == numWords)
+                        word &= myTailMask;
+                    const uint64_t diff = word ^ next[i];
+                    next[i] = word;
+                    if(y == firstY)
+                        top[i] = diff;
+                    if(y == lastY)
+                        bottom[i] = diff;
+                    west[i] |= diff & 1;
+                    east[i] |= diff >> (i + 1 == numWords ? tailEastBit : 63) & 1;
+                    changed[i] |= diff;
+                }
+                if(outStats)
+                {
+                    const uint64_t word = next[i];
+                    outStats->population += popcount64(word);
+                    outStats->births += popcount64(word & ~center[i]);
+                    outStats->deaths += popcount64(center[i] & ~word);
+                    columnMask[i] |= word;
+                    rowMask |= word;
+                }
+            }
+            // Only the rows count here, the columns come from the masks below
+            if(outStats && rowMask)
+                outStats->include(0, y);
+        }
+        for(int i = 0; i < numWords; i++)
+        {
+            if(!isAwake[i])
+            {
+                ++numSleeping;
+                continue;
+            }
+            uint8_t& quiet = myQuietCounts[(size_t)tileY * numWords + i];
+            quiet = changed[i] || !myIsHistoryValid ? 0 : std::min<uint8_t>(quiet + 1, kSleepAfter);
+            if(quiet < kSleepAfter)
+                wakeTile(tileY, i);
+            const int eastBit = i + 1 == numWords ? tailEastBit : 63;
+            if(top[i])
+                wakeTile(tileY - 1, i);
+            if(bottom[i])
+                wakeTile(tileY + 1, i);
+            if(west[i])
+                wakeTile(tileY, i - 1);
+            if(east[i])
+                wakeTile(tileY, i + 1);
+            if(top[i] & 1)
+                wakeTile(tileY - 1, i - 1);
+            if((top[i] >> eastBit) & 1)
+                wakeTile(tileY - 1, i + 1);
+            if(bottom[i] & 1)
+                wakeTile(tileY + 1, i - 1);
+            if((bottom[i] >> eastBit) & 1)
+                wakeTile(tileY + 1, i + 1);
+        }
+    }
+    myCells.swap(myNextCells);
+    myIsAwake.swap(myIsAwakeNext);
+    myIsHistoryValid = true;
+    mySleepingFraction = (double)numSleeping / myIsAwake.size();
+    if(outStats && outStats->population)
+    {
+        int first = 0, last = numWords - 1;
+        while(!columnMask[first]) ++first;
+        while(!columnMask[last]) --last;
+        outStats->minX = first * 64 + ctz64(columnMask[first]);
+        outStats->maxX = last * 64 + msb64(columnMask[last]);
+    }
+}
+
+void BitGrid::step(GenerationStats* outStats)
+{
+    if(myIsSleeping)
+    {
+        stepTiles(outStats);
+        return;
+    }
+    const int numWords = myWordsPerRow;
+    std::vector<uint64_t> columnMask;
+    if(outStats)
+    {
+        outStats->reset();
+        columnMask.assign(numWords, 0);
+    }
+    for(int y = 0; y < myHeight; y++)
+    {
+        const uint64_t* above = getRow(y == 0 ? myHeight - 1 : y - 1);
+        const uint64_t* center = getRow(y);
+        const uint64_t* below = getRow(y + 1 == myHeight ? 0 : y + 1);
+        uint64_t* next = &myNextCells[y * numWords];
+        uint64_t rowMask = 0;
+        for(int i = 0; i < numWords; i++)
+        {
+            uint64_t word = lifeWord(westOf(above, i, myWidth), above[i], eastOf(above, i, numWords, myWidth),
+                                     westOf(center, i, myWidth), center[i], eastOf(center, i, numWords, myWidth),
+                                     westOf(below, i, myWidth), below[i], eastOf(below, i, numWords, myWidth));
+            if(i + 1 == numWords)
+                word &= myTailMask;
+            next[i] = word;
+            if(outStats)
+            {
+                outStats->population += popcount64(word);
+                outStats->births += popcount64(word & ~center[i]);
+                outStats->deaths += popcount64(center[i] & ~word);
+                columnMask[i] |= word;
+                rowMask |= word;
+            }
+        }
+        if(outStats && rowMask)
+        {
+            if(outStats->maxY < outStats->minY)
+                outStats->minY = y;
+            outStats->maxY = y;
+        }
+    }
+    myCells.swap(myNextCells);
+    myIsHistoryValid = true;
+    if(outStats && outStats->population)
+    {
+        int first = 0, last = numWords - 1;
+        while(!columnMask[first]) ++first;
+        while(!columnMask[last]) --last;
+        outStats->minX = first * 64 + ctz64(columnMask[first]);
+        outStats->maxX = last * 64 + msb64(columnMask[last]);
+    }
+}
+
+/// <summary>
+/// aDepth generations from myCells into myNextCells, band by band
+/// </summary>
+void BitGrid::advanceBands(int aDepth)
+{
+    const int numWords = myWordsPerRow;
+    // Keep the recomputed halo well below the band itself
+    const int bandRows = std::max(4 * aDepth, (int)(kBandBytes / (8 * numWords)) - 2 * aDepth);
+    const int haloRows = bandRows + 2 * aDepth;
+    myBand.resize((size_t)haloRows * numWords);
+    myNextBand.resize(myBand.size());
+    for(int firstY = 0; firstY < myHeight; firstY += bandRows)
+    {
+        const int numRows = std::min(bandRows, myHeight - firstY) + 2 * aDepth;
+        for(int r = 0; r < numRows; r++)
+        {
+            const int y = ((firstY - aDepth + r) % myHeight + myHeight) % myHeight;
+            std::copy(&myCells[(size_t)y * numWords], &myCells[(size_t)y * numWords] + numWords, &myBand[(size_t)r * numWords]);
+        }
+        // The halo may wrap onto the band on short boards, the copies are still the right neighbours.
+        // After generation g only rows g to numRows - g - 1 are still exact.
+        for(int g = 1; g <= aDepth; g++)
+        {
+            for(int r = g; r < numRows - g; r++)
+            {
+                lifeRow(&myBand[(size_t)(r - 1) * numWords], &myBand[(size_t)r * numWords], &myBand[(size_t)(r + 1) * numWords],
+                        &myNextBand[(size_t)r * numWords], numWords, myWidth, myTailMask);
+            }
+            myBand.swap(myNextBand);
+        }
+        std::copy(&myBand[(size_t)aDepth * numWords], &myBand[(size_t)(numRows - aDepth) * numWords],
+                  &myNextCells[(size_t)firstY * numWords]);
+    }
+    myCells.swap(myNextCells);
+}
+
+void BitGrid::stepBlocked(uint64_t aGenerations, int aDepth)
+{
+    myIsHistoryValid = false;
+    aDepth = std::max(aDepth, 1);
+    for(; aGenerations >= (uint64_t)aDepth; aGenerations -= aDepth)
+        advanceBands(aDepth);
+    if(aGenerations)
+        advanceBands((int)aGenerations);
+}
+
+bool BitGrid::getChanges(ChangeList& outChanges) const
+{
+    if(!myIsHistoryValid)
+    {
+        outChanges.clear();
+        return false;
+    }
+    collectChanges(myCells.data(), myNextCells.data(), myWordsPerRow, myHeight, outChanges);
+    return true;
+}
+
+uint64_t BitGrid::getPopulation() const
+{
+    uint64_t result = 0;
+    for(uint64_t word : myCells)
+        result += popcount64(word);
+    return result;
+}
+
+uint64_t BitGrid::getHash() const
+{
+    uint64_t result = 0x84222325cbf29ce4ULL;
+    for(uint64_t word : myCells)
+        result = (result * 0x100000001b3ULL) ^ mix64(word);
+    return result;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct ChangeList;
+struct GenerationStats;
+
+/// <summary>
+/// Dense bit packed torus, 64 cells per word along x, rows stored one after another.
+/// Cells are addressed from (0, 0) to (width - 1, height - 1).
+/// </summary>
+class BitGrid
+{
+public:
+    // Sleeping tiles are one word wide and this many rows tall
+    static const int kTileRows = 64;
+    // Generations per pass of the temporally blocked step
+    static const int kBlockDepth = 8;
+
+    BitGrid(int aWidth = 64, int aHeight = 64);
+
+    /// <summary>
+    /// Change the board size, all cells die
+    /// </summary>
+    void resize(int aWidth, int aHeight);
+    void clear();
+
+    int getWidth() const { return myWidth; }
+    int getHeight() const { return myHeight; }
+    int getWordsPerRow() const { return myWordsPerRow; }
+    /// <summary>
+    /// Valid bits of the last word of a row
+    /// </summary>
+    uint64_t getTailMask() const { return myTailMask; }
+
+    bool get(int x, int y) const
+    {
+        return (myCells[y * myWordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void set(int x, int y, bool isLive);
+
+    const uint64_t* getRow(int y) const { return &myCells[y * myWordsPerRow]; }
+    /// <summary>
+    /// A row to write cells into. Sleeping tiles cannot see such edits, so this wakes the whole board.
+    /// </summary>
+    uint64_t* editRow(int y)
+    {
+        myIsHistoryValid = false;
+        return &myCells[y * myWordsPerRow];
+    }
+
+    /// <summary>
+    /// Advance one generation of B3/S23
+    /// </summary>
+    /// <param name="outStats">Optional, population and births/deaths by popcount of the output words</param>
+    void step(GenerationStats* outStats = nullptr);
+
+    /// <summary>
+    /// Advance aGenerations of B3/S23, aDepth at a time. Each band of rows is copied with an aDepth row halo
+    /// into a cache sized scratch and advanced there, the halo shrinking by a row per generation, so the board
+    /// goes through memory once per aDepth generations instead of once per generation.
+    /// </summary>
+    void stepBlocked(uint64_t aGenerations, int aDepth = kBlockDepth);
+
+    /// <summary>
+    /// Let tiles that were still or period 2 for the last few generations skip computation
+    /// until a neighbouring tile changes the cells along their shared border
+    /// </summary>
+    void setSleeping(bool isEnabled);
+    bool isSleeping() const { return myIsSleeping; }
+    /// <summary>
+    /// Fraction of the tiles skipped by the last step
+    /// </summary>
+    double getSleepingFraction() const { return mySleepingFraction; }
+
+    /// <summary>
+    /// Cells born and died in the last step, read off the scratch that still holds the generation before.
+    /// Costs a pass over the board words and nothing in step itself.
+    /// </summary>
+    /// <param name="outChanges">Cleared, then filled sorted by column then row like a TileSet</param>
+    /// <returns>False when cells changed outside step or by stepBlocked since, there is no previous generation then</returns>
+    bool getChanges(ChangeList& outChanges) const;
+
+    uint64_t getPopulation() const;
+    /// <summary>
+    /// Order dependent hash of the whole board, used to detect periodicity
+    /// </summary>
+    uint64_t getHash() const;
+
+    bool operator==(const BitGrid& anOther) const
+    {
+        return myWidth == anOther.myWidth && myHeight == anOther.myHeight && myCells == anOther.myCells;
+    }
+
+private:
+    void stepTiles(GenerationStats* outStats);
+    void wakeTile(int aTileY, int aTileX);
+    void advanceBands(int aDepth);
+
+    int myWidth, myHeight, myWordsPerRow;
+    uint64_t myTailMask;
+    std::vector<uint64_t> myCells;
+    // Scratch for the next generation, which still holds the generation before the current one
+    std::vector<uint64_t> myNextCells;
+
+    bool myIsSleeping;
+    // Cleared when cells change outside step, the previous generation cannot be trusted then
+    bool myIsHistoryValid;
+    int myTilesPerColumn;
+    double mySleepingFraction;
+    // Generations in a row each tile matched its state two generations earlier
+    std::vector<uint8_t> myQuietCounts;
+    std::vector<uint8_t> myIsAwake;
+    std::vector<uint8_t> myIsAwakeNext;
+    // Band scratch of the blocked step
+    std::vector<uint64_t> myBand, myNextBand;
+};
+
+/// <summary>
+/// Next state of a word of cells from its 3x3 neighbourhood words, the core adder network.
+/// Each argument holds the cells shifted so that bit x refers to the neighbour of cell x.
+/// </summary>
+static inline uint64_t lifeWord(uint64_t aNW, uint64_t aN, uint64_t aNE,
+                                uint64_t aW, uint64_t aCenter, uint64_t aE,
+                                uint64_t aSW, uint64_t aS, uint64_t aSE)
+{
+    // Rows above and below through full adders, the middle row through a half adder
+    uint64_t sumA = aNW ^ aN ^ aNE, carryA = (aNW & aN) | (aNE & (aNW ^ aN));
+    uint64_t sumB = aSW ^ aS ^ aSE, carryB = (aSW & aS) | (aSE & (aSW ^ aS));
+    uint64_t sumM = aW ^ aE, carryM = aW & aE;
+    // Ones of the total and one more carry into the twos
+    uint64_t ones = sumA ^ sumB ^ sumM, carryO = (sumA & sumB) | (sumM & (sumA ^ sumB));
+    // Total is 2 or 3 exactly when one of the four twos is set
+    uint64_t exactlyOneTwo = (carryA ^ carryB ^ carryM ^ carryO) & ~((carryA & carryB) | (carryM & carryO));
+    return exactlyOneTwo & (ones | aCenter);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// <summary>
+/// Number of set bits in a word
+/// </summary>
+static inline int popcount64(uint64_t aWord)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(aWord);
+#else
+    return __builtin_popcountll(aWord);
+#endif
+}
+
+/// <summary>
+/// Index of the lowest set bit, aWord must not be 0
+/// </summary>
+static inline int ctz64(uint64_t aWord)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, aWord);
+    return (int)index;
+#else
+    return __builtin_ctzll(aWord);
+#endif
+}
+
+/// <summary>
+/// Index of the highest set bit, aWord must not be 0
+/// </summary>
+static inline int msb64(uint64_t aWord)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, aWord);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(aWord);
+#endif
+}
+
+/// <summary>
+/// Finalizer of splitmix64, a cheap well distributed 64 bit mix
+/// </summary>
+static inline uint64_t mix64(uint64_t aValue)
+{
+    aValue ^= aValue >> 30;
+    aValue *= 0xbf58476d1ce4e5b9ULL;
+    aValue ^= aValue >> 27;
+    aValue *= 0x94d049bb133111ebULL;
+    aValue ^= aValue >> 31;
+    return aValue;
+}
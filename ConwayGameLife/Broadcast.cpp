@@ -0,0 +1,252 @@
+#include "Broadcast.h"
+#include <algorithm>
+#include <cstdlib>
+#include "BitGrid.h"
+#include "BitOps.h"
+#include "Changes.h"
+#include "Log.h"
+#include "Pattern.h"
+#include "TileSet.h"
+
+// Records queued for a client before it is considered stalled, about two seconds at the default rate
+static const size_t kMaxQueuedRecords = 64;
+static const double kDefaultRate = 30.0;
+static const float kReportSeconds = 5.f;
+
+BroadcastServer::BroadcastServer()
+    : myHalfSide(0)
+{
+}
+
+bool BroadcastServer::open(unsigned short aPort, int aHalfSide)
+{
+    myHalfSide = aHalfSide;
+    if(sf::Socket::Done != myListener.listen(aPort))
+        return false;
+    myListener.setBlocking(false);
+    mySelector.add(myListener);
+    myReportClock.restart();
+    return true;
+}
+
+void BroadcastServer::poll(sf::Time aTimeout)
+{
+    if(mySelector.wait(aTimeout) && mySelector.isReady(myListener))
+        accept();
+    for(auto& client : myClients)
+    {
+        // Viewers have nothing to say, reading only notices them leaving
+        if(mySelector.isReady(*client->socket))
+        {
+            char buffer[256];
+            size_t received;
+            sf::Socket::Status status = client->socket->receive(buffer, sizeof(buffer), received);
+            if(sf::Socket::Disconnected == status || sf::Socket::Error == status)
+                client->isClosed = true;
+        }
+        if(!client->isClosed)
+            send(*client);
+    }
+    for(auto& client : myClients)
+    {
+        if(client->isClosed)
+        {
+            LOG_INFO("viewer %s left, %.1f kB sent, %llu resyncs\n", client->address.c_str(),
+                     client->bytesSent / 1024.0, (unsigned long long)client->numResyncs);
+            mySelector.remove(*client->socket);
+        }
+    }
+    myClients.erase(std::remove_if(myClients.begin(), myClients.end(),
+                                   [](const std::unique_ptr<Client>& aClient) { return aClient->isClosed; }),
+                    myClients.end());
+    if(myReportClock.getElapsedTime().asSeconds() >= kReportSeconds)
+        report();
+}
+
+void BroadcastServer::accept()
+{
+    for(;;)
+    {
+        auto client = std::make_unique<Client>();
+        client->socket = std::make_unique<sf::TcpSocket>();
+        if(sf::Socket::Done != myListener.accept(*client->socket))
+            return;
+        client->socket->setBlocking(false);
+        client->address = client->socket->getRemoteAddress().toString() + ":" + std::to_string(client->socket->getRemotePort());
+        auto header = std::make_shared<std::vector<uint8_t>>();
+        writeStreamHeader(myHalfSide, *header);
+        client->queue.push_back(header);
+        mySelector.add(*client->socket);
+        LOG_INFO("viewer %s joined, %d watching\n", client->address.c_str(), (int)myClients.size() + 1);
+        myClients.push_back(std::move(client));
+    }
+}
+
+void BroadcastServer::send(Client& aClient)
+{
+    while(!aClient.queue.empty())
+    {
+        const std::vector<uint8_t>& record = *aClient.queue.front();
+        size_t sent = 0;
+        sf::Socket::Status status = aClient.socket->send(record.data() + aClient.sentOfFirst, record.size() - aClient.sentOfFirst, sent);
+        aClient.sentOfFirst += sent;
+        aClient.bytesSent += sent;
+        if(aClient.sentOfFirst == record.size())
+        {
+            aClient.queue.pop_front();
+            aClient.sentOfFirst = 0;
+        }
+        if(sf::Socket::Disconnected == status || sf::Socket::Error == status)
+        {
+            aClient.isClosed = true;
+            return;
+        }
+        if(sf::Socket::Done != status)
+            return; // The socket buffer is full, the rest waits for the next poll
+    }
+}
+
+void BroadcastServer::drop(Client& aClient)
+{
+    // The record on the wire has to finish or the viewer loses its place in the stream
+    const bool isSending = aClient.sentOfFirst > 0;
+    while(aClient.queue.size() > (isSending ? 1u : 0u))
+        aClient.queue.pop_back();
+    aClient.needsKeyframe = true;
+    ++aClient.numResyncs;
+}
+
+bool BroadcastServer::needsKeyframe() const
+{
+    for(auto& client : myClients)
+    {
+        if(client->needsKeyframe || client->queue.size() >= kMaxQueuedRecords)
+            return true;
+    }
+    return false;
+}
+
+void BroadcastServer::requestKeyframe()
+{
+    for(auto& client : myClients)
+        client->needsKeyframe = true;
+}
+
+void BroadcastServer::publish(uint64_t aGeneration, const ChangeList& someChanges, const std::vector<sf::Vector2i>& someLiveCells)
+{
+    // Each kind of record is encoded once, whatever the number of clients
+    std::shared_ptr<std::vector<uint8_t>> delta, keyframe;
+    for(auto& client : myClients)
+    {
+        if(client->queue.size() >= kMaxQueuedRecords)
+            drop(*client);
+        if(client->needsKeyframe)
+        {
+            if(!keyframe)
+            {
+                ChangeList cells;
+                cells.births = someLiveCells;
+                keyframe = std::make_shared<std::vector<uint8_t>>();
+                writeStreamRecord(aGeneration, true, cells, myHalfSide, *keyframe);
+            }
+            client->queue.push_back(keyframe);
+            client->needsKeyframe = false;
+        }
+        else
+        {
+            if(!delta)
+            {
+                delta = std::make_shared<std::vector<uint8_t>>();
+                writeStreamRecord(aGeneration, false, someChanges, myHalfSide, *delta);
+            }
+            client->queue.push_back(delta);
+        }
+        send(*client);
+    }
+}
+
+void BroadcastServer::report()
+{
+    const float seconds = myReportClock.restart().asSeconds();
+    for(auto& client : myClients)
+    {
+        LOG_INFO("viewer %s: %.1f kB/s, %.1f kB total, %d queued, %llu resyncs\n", client->address.c_str(),
+                 (client->bytesSent - client->bytesReported) / 1024.0 / seconds, client->bytesSent / 1024.0,
+                 (int)client->queue.size(), (unsigned long long)client->numResyncs);
+        client->bytesReported = client->bytesSent;
+    }
+}
+
+/// <summary>
+/// Live cells as world tiles
+/// </summary>
+static void collectCells(const BitGrid& aGrid, int aHalfSide, std::vector<sf::Vector2i>& outCells)
+{
+    outCells.clear();
+    for(int y = 0; y < aGrid.getHeight(); y++)
+    {
+        const uint64_t* row = aGrid.getRow(y);
+        for(int i = 0; i < aGrid.getWordsPerRow(); i++)
+        {
+            for(uint64_t word = row[i]; word; word &= word - 1)
+                outCells.push_back(sf::Vector2i(i * 64 + ctz64(word) - aHalfSide, y - aHalfSide));
+        }
+    }
+    // Column order, as the codec expects
+    std::sort(outCells.begin(), outCells.end(), TileComparator());
+}
+
+int runBroadcast(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        LOG_INFO("usage: --serve <port> <side> <pattern.rle | density> [generations per second] [seed]\n");
+        return 1;
+    }
+    const unsigned short port = (unsigned short)atoi(argv[0]);
+    const int halfSide = std::max(1, atoi(argv[1]) / 2), side = 2 * halfSide;
+    const double rate = argc > 3 ? std::max(0.1, atof(argv[3])) : kDefaultRate;
+    BitGrid grid(side, side);
+    grid.setSleeping(true);
+    std::vector<sf::Vector2i> cells;
+    makeBoard(argv[2], side, argc > 4 ? strtoull(argv[4], nullptr, 10) : 0, cells);
+    for(auto& cell : cells)
+        grid.set(cell.x, cell.y, true);
+    BroadcastServer server;
+    if(!server.open(port, halfSide))
+    {
+        LOG_ERROR("failed to listen on port %d\n", (int)port);
+        return 1;
+    }
+    LOG_INFO("serving %dx%d at %g gen/s on port %d\n", side, side, rate, (int)port);
+    const sf::Time interval = sf::seconds((float)(1.0 / rate));
+    sf::Clock clock;
+    sf::Time nextStep = sf::Time::Zero;
+    ChangeList changes;
+    uint64_t generation = 0;
+    for(;;)
+    {
+        // Waiting on the sockets doubles as the pacing sleep
+        server.poll(std::max(sf::microseconds(1), nextStep - clock.getElapsedTime()));
+        if(clock.getElapsedTime() < nextStep)
+            continue;
+        nextStep += interval;
+        // Nobody would see the time lost while the board runs slower than the rate
+        if(nextStep < clock.getElapsedTime())
+            nextStep = clock.getElapsedTime();
+        grid.step();
+        ++generation;
+        if(!server.getNumClients())
+            continue;
+        if(!grid.getChanges(changes))
+            server.requestKeyframe();
+        for(auto& cell : changes.births)
+            cell -= sf::Vector2i(halfSide, halfSide);
+        for(auto& cell : changes.deaths)
+            cell -= sf::Vector2i(halfSide, halfSide);
+        if(server.needsKeyframe())
+            collectCells(grid, halfSide, cells);
+        server.publish(generation, changes, cells);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ChangeList;
+
+/// <summary>
+/// Sends the delta stream of a running board to any number of TCP viewers. Sockets never block the
+/// simulation, each client has its own queue of records. A client that falls too far behind loses what
+/// is queued and picks up again from a keyframe of the next generation.
+/// </summary>
+class BroadcastServer
+{
+public:
+    BroadcastServer();
+    BroadcastServer(const BroadcastServer&) = delete;
+    BroadcastServer& operator=(const BroadcastServer&) = delete;
+
+    /// <param name="aHalfSide">Half length of the torus, sent to viewers in the stream header</param>
+    bool open(unsigned short aPort, int aHalfSide);
+
+    /// <summary>
+    /// Accept new viewers and push queued bytes, waiting up to aTimeout for a connection or data
+    /// </summary>
+    void poll(sf::Time aTimeout);
+
+    /// <summary>
+    /// If any client has to start over, the caller then passes the whole board to publish
+    /// </summary>
+    bool needsKeyframe() const;
+    /// <summary>
+    /// Make every client start over, when the board changed in a way the deltas do not describe
+    /// </summary>
+    void requestKeyframe();
+
+    /// <summary>
+    /// Queue one generation to every client, its changes or a keyframe for clients that need one
+    /// </summary>
+    /// <param name="someLiveCells">The board after this generation, only read when needsKeyframe</param>
+    void publish(uint64_t aGeneration, const ChangeList& someChanges, const std::vector<sf::Vector2i>& someLiveCells);
+
+    /// <summary>
+    /// Log the outgoing rate of each client since the last report
+    /// </summary>
+    void report();
+
+    size_t getNumClients() const { return myClients.size(); }
+
+private:
+    struct Client
+    {
+        std::unique_ptr<sf::TcpSocket> socket;
+        std::string address;
+        // Whole records, the first one possibly partly sent already
+        std::deque<std::shared_ptr<const std::vector<uint8_t>>> queue;
+        size_t sentOfFirst = 0;
+        bool needsKeyframe = true;
+        bool isClosed = false;
+        uint64_t bytesSent = 0;
+        uint64_t bytesReported = 0;
+        uint64_t numResyncs = 0;
+    };
+
+    void accept();
+    void send(Client& aClient);
+    void drop(Client& aClient);
+
+    sf::TcpListener myListener;
+    sf::SocketSelector mySelector;
+    std::vector<std::unique_ptr<Client>> myClients;
+    int myHalfSide;
+    sf::Clock myReportClock;
+};
+
+/// <summary>
+/// Command line entry, "--serve <port> <side> <pattern.rle | density> [generations per second] [seed]"
+/// </summary>
+int runBroadcast(int argc, char* argv[]);
@@ -0,0 +1,399 @@
+#include "Census.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BitGrid.h"
+#include "BitOps.h"
+#include "Log.h"
+#include "Parallel.h"
+
+// Cells closer than this (Chebyshev distance) belong to the same object, so pseudo objects stay together
+static const int kCensusDistance = 2;
+// Objects not repeating within this many generations in isolation are left unclassified
+static const int kMaxPeriod = 32;
+// Bigger objects are debris of an unsettled board and are not run at all
+static const size_t kMaxObjectSize = 1024;
+
+struct CensusCell
+{
+    int x, y;
+    bool operator<(const CensusCell& anOther) const
+    {
+        return y < anOther.y || (y == anOther.y && x < anOther.x);
+    }
+    bool operator==(const CensusCell& anOther) const
+    {
+        return x == anOther.x && y == anOther.y;
+    }
+};
+
+typedef std::vector<CensusCell> CellList;
+
+/// <summary>
+/// Shape key, bounding box size followed by the rows as hex nibbles
+/// </summary>
+static std::string shapeKey(const CellList& someCells)
+{
+    int minX = someCells[0].x, minY = someCells[0].y, maxX = minX, maxY = minY;
+    for(auto& cell : someCells)
+    {
+        minX = std::min(minX, cell.x); maxX = std::max(maxX, cell.x);
+        minY = std::min(minY, cell.y); maxY = std::max(maxY, cell.y);
+    }
+    int width = maxX - minX + 1, height = maxY - minY + 1;
+    int nibblesPerRow = (width + 3) / 4;
+    std::vector<unsigned char> nibbles((size_t)nibblesPerRow * height, 0);
+    for(auto& cell : someCells)
+    {
+        int x = cell.x - minX, y = cell.y - minY;
+        nibbles[y * nibblesPerRow + x / 4] |= 1 << (x & 3);
+    }
+    std::string result = std::to_string(width) + "x" + std::to_string(height) + "_";
+    for(int y = 0; y < height; y++)
+    {
+        if(y)
+            result += '.';
+        for(int i = 0; i < nibblesPerRow; i++)
+            result += "0123456789abcdef"[nibbles[y * nibblesPerRow + i]];
+    }
+    return result;
+}
+
+/// <summary>
+/// Move the cells so the bounding box starts at the origin and sort them
+/// </summary>
+static void normalise(CellList& someCells, int& outMinX, int& outMinY)
+{
+    outMinX = someCells[0].x;
+    outMinY = someCells[0].y;
+    for(auto& cell : someCells)
+    {
+        outMinX = std::min(outMinX, cell.x);
+        outMinY = std::min(outMinY, cell.y);
+    }
+    for(auto& cell : someCells)
+    {
+        cell.x -= outMinX;
+        cell.y -= outMinY;
+    }
+    std::sort(someCells.begin(), someCells.end());
+}
+
+static bool shapeLess(const CellList& lhs, const CellList& rhs)
+{
+    if(lhs.size() != rhs.size())
+        return lhs.size() < rhs.size();
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+/// <summary>
+/// Smallest of the 8 rotations and reflections of a shape
+/// </summary>
+static void canonicalise(const CellList& someCells, CellList& outCanonical)
+{
+    CellList transformed(someCells.size());
+    int minX, minY;
+    for(int symmetry = 0; symmetry < 8; symmetry++)
+    {
+        for(size_t i = 0; i < someCells.size(); i++)
+        {
+            int x = someCells[i].x, y = someCells[i].y;
+            if(symmetry & 4)
+                std::swap(x, y);
+            transformed[i].x = (symmetry & 1) ? -x : x;
+            transformed[i].y = (symmetry & 2) ? -y : y;
+        }
+        normalise(transformed, minX, minY);
+        if(0 == symmetry || shapeLess(transformed, outCanonical))
+            outCanonical = transformed;
+    }
+}
+
+static uint64_t hashCells(const CellList& someCells)
+{
+    uint64_t result = 0x84222325cbf29ce4ULL;
+    for(auto& cell : someCells)
+        result = (result * 0x100000001b3ULL) ^ mix64(((uint64_t)(uint32_t)cell.y << 32) | (uint32_t)cell.x);
+    return result;
+}
+
+/// <summary>
+/// Run an object alone until it repeats and name it by its canonical form over all phases,
+/// xs[population] for still lifes, xp[period] for oscillators, xq[period] for spaceships, zz when unknown
+/// </summary>
+static std::string classify(const CellList& someNormalisedCells)
+{
+    int width = 0, height = 0;
+    for(auto& cell : someNormalisedCells)
+    {
+        width = std::max(width, cell.x + 1);
+        height = std::max(height, cell.y + 1);
+    }
+    // Nothing in Life outruns c/2 orthogonally, so this margin holds every phase
+    const int margin = kMaxPeriod / 2 + 2;
+    BitGrid grid(width + 2 * margin, height + 2 * margin);
+    for(auto& cell : someNormalisedCells)
+        grid.set(cell.x + margin, cell.y + margin, true);
+    std::vector<CellList> phases(1, someNormalisedCells);
+    CellList phase;
+    int period = 0, minX = 0, minY = 0;
+    for(int generation = 1; generation <= kMaxPeriod && someNormalisedCells.size() <= kMaxObjectSize; generation++)
+    {
+        grid.step();
+        phase.clear();
+        for(int y = 0; y < grid.getHeight(); y++)
+        {
+            const uint64_t* row = grid.getRow(y);
+            for(int i = 0; i < grid.getWordsPerRow(); i++)
+            {
+                for(uint64_t word = row[i]; word; word &= word - 1)
+                    phase.push_back({ i * 64 + ctz64(word), y });
+            }
+        }
+        if(phase.empty())
+            break;
+        normalise(phase, minX, minY);
+        if(phase == someNormalisedCells)
+        {
+            period = generation;
+            break;
+        }
+        phases.push_back(phase);
+    }
+    // Periodic objects take the smallest form over all phases, the rest their current one
+    CellList best, canonical;
+    for(size_t i = 0; i < (period ? phases.size() : 1); i++)
+    {
+        canonicalise(phases[i], canonical);
+        if(0 == i || shapeLess(canonical, best))
+            best = canonical;
+    }
+    std::string prefix;
+    if(0 == period)
+        prefix = "zz";
+    else if(1 == period)
+        prefix = "xs" + std::to_string(someNormalisedCells.size());
+    else if(minX != margin || minY != margin)
+        prefix = "xq" + std::to_string(period);
+    else
+        prefix = "xp" + std::to_string(period);
+    return prefix + "_" + shapeKey(best);
+}
+
+static uint32_t findRoot(std::vector<uint32_t>& someParents, uint32_t anIndex)
+{
+    while(someParents[anIndex] != anIndex)
+    {
+        someParents[anIndex] = someParents[someParents[anIndex]];
+        anIndex = someParents[anIndex];
+    }
+    return anIndex;
+}
+
+/// <summary>
+/// Read only root lookup, safe while other threads do the same
+/// </summary>
+static uint32_t peekRoot(const std::vector<uint32_t>& someParents, uint32_t anIndex)
+{
+    while(someParents[anIndex] != anIndex)
+        anIndex = someParents[anIndex];
+    return anIndex;
+}
+
+static void unite(std::vector<uint32_t>& someParents, uint32_t anIndex, uint32_t anOther)
+{
+    anIndex = findRoot(someParents, anIndex);
+    anOther = findRoot(someParents, anOther);
+    if(anIndex < anOther)
+        someParents[anOther] = anIndex;
+    else if(anOther < anIndex)
+        someParents[anIndex] = anOther;
+}
+
+template<typename F>
+static void forEachLiveCell(const BitGrid& aGrid, int aBeginRow, int anEndRow, F aFunction)
+{
+    for(int y = aBeginRow; y < anEndRow; y++)
+    {
+        const uint64_t* row = aGrid.getRow(y);
+        for(int i = 0; i < aGrid.getWordsPerRow(); i++)
+        {
+            for(uint64_t word = row[i]; word; word &= word - 1)
+                aFunction(i * 64 + ctz64(word), y);
+        }
+    }
+}
+
+void takeCensus(const BitGrid& aGrid, CensusTable& outTable, unsigned aNumThreads)
+{
+    const int width = aGrid.getWidth(), height = aGrid.getHeight();
+    const int numStrips = std::max(1, std::min((int)std::max(1u, aNumThreads), height / (2 * kCensusDistance)));
+    auto stripBegin = [height, numStrips](int aStrip) { return (int)((int64_t)height * aStrip / numStrips); };
+    // Union find over cell indices, only entries of live cells are meaningful
+    std::vector<uint32_t> parents((size_t)width * height);
+    auto wrapX = [width](int x) { return (x % width + width) % width; };
+
+    // Label every strip on its own, looking back only at cells already inside the strip.
+    // As many threads as strips, so each range runStrips hands out is the one strip.
+    runStrips(numStrips, numStrips, [&](int aStrip, int)
+    {
+        const int begin = stripBegin(aStrip), end = stripBegin(aStrip + 1);
+        forEachLiveCell(aGrid, begin, end, [&](int x, int y) { parents[y * width + x] = y * width + x; });
+        forEachLiveCell(aGrid, begin, end, [&](int x, int y)
+        {
+            for(int dy = -kCensusDistance; dy <= 0; dy++)
+            {
+                if(y + dy < begin)
+                    continue;
+                for(int dx = -kCensusDistance; dx <= (dy ? kCensusDistance : -1); dx++)
+                {
+                    int nx = wrapX(x + dx);
+                    if(aGrid.get(nx, y + dy))
+                        unite(parents, y * width + x, (y + dy) * width + nx);
+                }
+            }
+        });
+    });
+    // Stitch the strips together, including the seam of the torus
+    for(int strip = 0; strip < numStrips; strip++)
+    {
+        const int begin = stripBegin(strip);
+        forEachLiveCell(aGrid, begin, std::min(begin + kCensusDistance, height), [&](int x, int y)
+        {
+            for(int dy = -kCensusDistance; dy < 0; dy++)
+            {
+                if(y + dy >= begin)
+                    continue;
+                int ny = (y + dy + height) % height;
+                for(int dx = -kCensusDistance; dx <= kCensusDistance; dx++)
+                {
+                    int nx = wrapX(x + dx);
+                    if(aGrid.get(nx, ny))
+                        unite(parents, y * width + x, ny * width + nx);
+                }
+            }
+        });
+    }
+
+    // Gather cells by root
+    struct RootedCell
+    {
+        uint32_t root;
+        CensusCell cell;
+        bool operator<(const RootedCell& anOther) const { return root < anOther.root; }
+    };
+    std::vector<std::vector<RootedCell>> stripCells(numStrips);
+    runStrips(numStrips, numStrips, [&](int aStrip, int)
+    {
+        forEachLiveCell(aGrid, stripBegin(aStrip), stripBegin(aStrip + 1), [&](int x, int y)
+        {
+            stripCells[aStrip].push_back({ peekRoot(parents, y * width + x), { x, y } });
+        });
+    });
+    std::vector<RootedCell> cells;
+    for(auto& strip : stripCells)
+        cells.insert(cells.end(), strip.begin(), strip.end());
+    std::stable_sort(cells.begin(), cells.end());
+    std::vector<size_t> objectStarts;
+    for(size_t i = 0; i < cells.size(); i++)
+    {
+        if(0 == i || cells[i].root != cells[i - 1].root)
+            objectStarts.push_back(i);
+    }
+    objectStarts.push_back(cells.size());
+
+    // Classify the objects, every thread with its own cache and table
+    const size_t numObjects = objectStarts.size() - 1;
+    std::vector<CensusTable> stripTables(numStrips);
+    runStrips(numStrips, numStrips, [&](int aStrip, int)
+    {
+        std::unordered_map<uint64_t, std::string> names;
+        std::unordered_map<uint64_t, uint64_t> counts;
+        CellList object;
+        int minX, minY;
+        for(size_t i = aStrip; i < numObjects; i += numStrips)
+        {
+            // Unwrap around the first cell, objects are much smaller than the torus
+            object.clear();
+            const CensusCell origin = cells[objectStarts[i]].cell;
+            for(size_t j = objectStarts[i]; j < objectStarts[i + 1]; j++)
+            {
+                CensusCell cell = cells[j].cell;
+                int dx = cell.x - origin.x, dy = cell.y - origin.y;
+                if(dx >= width / 2) dx -= width; else if(dx < -width / 2) dx += width;
+                if(dy >= height / 2) dy -= height; else if(dy < -height / 2) dy += height;
+                object.push_back({ dx, dy });
+            }
+            normalise(object, minX, minY);
+            uint64_t hash = hashCells(object);
+            if(names.end() == names.find(hash))
+                names[hash] = classify(object);
+            ++counts[hash];
+        }
+        for(auto& entry : counts)
+            stripTables[aStrip][names[entry.first]] += entry.second;
+    });
+    for(auto& table : stripTables)
+        mergeCensus(table, outTable);
+}
+
+void mergeCensus(const CensusTable& aTable, CensusTable& outTable)
+{
+    for(auto& entry : aTable)
+        outTable[entry.first] += entry.second;
+}
+
+void printCensus(const CensusTable& aTable, size_t aMaxRows)
+{
+    std::vector<std::pair<std::string, uint64_t>> rows(aTable.begin(), aTable.end());
+    // Ties broken by key so the output only depends on the table
+    std::stable_sort(rows.begin(), rows.end(), [](const std::pair<std::string, uint64_t>& lhs,
+                                                  const std::pair<std::string, uint64_t>& rhs)
+    {
+        return lhs.second > rhs.second;
+    });
+    for(size_t i = 0; i < rows.size() && i < aMaxRows; i++)
+        LOG_INFO("%12llu  %s\n", (unsigned long long)rows[i].second, rows[i].first.c_str());
+}
+
+int runCensus(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        LOG_INFO("usage: --census <side> <generations> [threads] [seed]\n");
+        return 1;
+    }
+    int side = atoi(argv[0]);
+    int generations = atoi(argv[1]);
+    unsigned numThreads = argc > 2 ? (unsigned)atoi(argv[2]) : std::thread::hardware_concurrency();
+    if(0 == numThreads)
+        numThreads = 1;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+    BitGrid grid(side, side);
+    grid.setSleeping(true);
+    std::mt19937_64 random(seed);
+    for(int y = 0; y < side; y++)
+    {
+        uint64_t* row = grid.editRow(y);
+        for(int i = 0; i < grid.getWordsPerRow(); i++)
+            row[i] = random() & (i + 1 == grid.getWordsPerRow() ? grid.getTailMask() : ~0ULL);
+    }
+    for(int i = 0; i < generations; i++)
+        grid.step();
+    auto start = std::chrono::steady_clock::now();
+    CensusTable table;
+    takeCensus(grid, table, numThreads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t numObjects = 0;
+    for(auto& entry : table)
+        numObjects += entry.second;
+    LOG_INFO("%dx%d census of %llu cells, %llu objects in %.3f s on %u threads\n", side, side,
+           (unsigned long long)grid.getPopulation(), (unsigned long long)numObjects, seconds, numThreads);
+    printCensus(table, 50);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+
+class BitGrid;
+
+/// <summary>
+/// Object key to number of occurrences
+/// </summary>
+typedef std::map<std::string, uint64_t> CensusTable;
+
+/// <summary>
+/// Split the board into objects (cells within distance 2 of each other) with a strip parallel union find,
+/// then count them by their canonical form over the 8 symmetries and all phases
+/// </summary>
+void takeCensus(const BitGrid& aGrid, CensusTable& outTable, unsigned aNumThreads = 1);
+
+void mergeCensus(const CensusTable& aTable, CensusTable& outTable);
+
+/// <summary>
+/// Print the most frequent objects first
+/// </summary>
+void printCensus(const CensusTable& aTable, size_t aMaxRows);
+
+/// <summary>
+/// Command line entry, "--census <side> <generations> [threads] [seed]" runs a random board and times its census
+/// </summary>
+int runCensus(int argc, char* argv[]);
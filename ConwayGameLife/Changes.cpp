@@ -0,0 +1,183 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Changes.h"
+#include <cstddef>
+#include <cstring>
+
+static const char kDeltaMagic[8] = { 'L', 'I', 'F', 'E', 'D', 'L', 'T', 'A' };
+// Sanity limit on a decoded list, a corrupt count should not allocate the world
+static const uint64_t kMaxDecodedCells = 1ULL << 32;
+
+void writeVarint(uint64_t aValue, std::vector<uint8_t>& outBytes)
+{
+    while(aValue >= 0x80)
+    {
+        outBytes.push_back((uint8_t)(aValue | 0x80));
+        aValue >>= 7;
+    }
+    outBytes.push_back((uint8_t)aValue);
+}
+
+bool readVarint(const uint8_t*& ioCursor, const uint8_t* anEnd, uint64_t& outValue)
+{
+    outValue = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if(ioCursor == anEnd)
+            return false;
+        uint8_t byte = *ioCursor++;
+        outValue |= (uint64_t)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void encodeCells(const std::vector<sf::Vector2i>& someCells, int anOffset, std::vector<uint8_t>& outBytes)
+{
+    // Count runs first so the decoder knows how many follow
+    size_t numRuns = 0;
+    for(size_t i = 0; i < someCells.size(); i++)
+    {
+        if(0 == i || someCells[i].x != someCells[i - 1].x || someCells[i].y != someCells[i - 1].y + 1)
+            ++numRuns;
+    }
+    writeVarint(numRuns, outBytes);
+    int lastX = 0, lastEnd = 0;
+    for(size_t i = 0; i < someCells.size();)
+    {
+        size_t end = i + 1;
+        while(end < someCells.size() && someCells[end].x == someCells[i].x && someCells[end].y == someCells[end - 1].y + 1)
+            ++end;
+        const int x = someCells[i].x + anOffset, y = someCells[i].y + anOffset;
+        writeVarint((uint64_t)(x - lastX), outBytes);
+        writeVarint((uint64_t)(x == lastX && i > 0 ? y - lastEnd : y), outBytes);
+        writeVarint(end - i - 1, outBytes);
+        lastX = x;
+        lastEnd = y + (int)(end - i);
+        i = end;
+    }
+}
+
+static bool decodeCells(const uint8_t*& ioCursor, const uint8_t* anEnd, int anOffset, std::vector<sf::Vector2i>& outCells)
+{
+    outCells.clear();
+    uint64_t numRuns;
+    if(!readVarint(ioCursor, anEnd, numRuns) || numRuns > kMaxDecodedCells)
+        return false;
+    int64_t lastX = 0, lastEnd = 0;
+    for(uint64_t run = 0; run < numRuns; run++)
+    {
+        uint64_t dx, y, length;
+        if(!readVarint(ioCursor, anEnd, dx) || !readVarint(ioCursor, anEnd, y) || !readVarint(ioCursor, anEnd, length))
+            return false;
+        const int64_t x = lastX + (int64_t)dx;
+        const int64_t first = 0 == dx && run > 0 ? lastEnd + (int64_t)y : (int64_t)y;
+        if(outCells.size() + length >= kMaxDecodedCells)
+            return false;
+        for(uint64_t i = 0; i <= length; i++)
+            outCells.push_back(sf::Vector2i((int)(x - anOffset), (int)(first + (int64_t)i - anOffset)));
+        lastX = x;
+        lastEnd = first + (int64_t)length + 1;
+    }
+    return true;
+}
+
+void encodeChanges(const ChangeList& someChanges, int anOffset, std::vector<uint8_t>& outBytes)
+{
+    encodeCells(someChanges.births, anOffset, outBytes);
+    encodeCells(someChanges.deaths, anOffset, outBytes);
+}
+
+bool decodeChanges(const uint8_t*& ioCursor, const uint8_t* anEnd, int anOffset, ChangeList& outChanges)
+{
+    return decodeCells(ioCursor, anEnd, anOffset, outChanges.births) && decodeCells(ioCursor, anEnd, anOffset, outChanges.deaths);
+}
+
+void writeStreamHeader(int aHalfSide, std::vector<uint8_t>& outBytes)
+{
+    outBytes.insert(outBytes.end(), kDeltaMagic, kDeltaMagic + sizeof(kDeltaMagic));
+    writeVarint(2 * aHalfSide, outBytes);
+}
+
+bool readStreamHeader(const uint8_t*& ioCursor, const uint8_t* anEnd, int& outHalfSide)
+{
+    const uint8_t* cursor = ioCursor;
+    uint64_t side;
+    if(anEnd - cursor < (ptrdiff_t)sizeof(kDeltaMagic) || 0 != memcmp(cursor, kDeltaMagic, sizeof(kDeltaMagic)))
+        return false;
+    cursor += sizeof(kDeltaMagic);
+    if(!readVarint(cursor, anEnd, side) || side < 2 || side > (1 << 30))
+        return false;
+    outHalfSide = (int)(side / 2);
+    ioCursor = cursor;
+    return true;
+}
+
+void writeStreamRecord(uint64_t aGeneration, bool isKeyframe, const ChangeList& someChanges, int aHalfSide,
+                       std::vector<uint8_t>& outBytes)
+{
+    writeVarint(aGeneration, outBytes);
+    outBytes.push_back(isKeyframe ? 1 : 0);
+    encodeChanges(someChanges, aHalfSide, outBytes);
+}
+
+bool readStreamRecord(const uint8_t*& ioCursor, const uint8_t* anEnd, int aHalfSide, uint64_t& outGeneration, bool& outIsKeyframe,
+                      ChangeList& outChanges)
+{
+    const uint8_t* cursor = ioCursor;
+    if(!readVarint(cursor, anEnd, outGeneration) || cursor == anEnd)
+        return false;
+    outIsKeyframe = 0 != *cursor++;
+    if(!decodeChanges(cursor, anEnd, aHalfSide, outChanges))
+        return false;
+    ioCursor = cursor;
+    return true;
+}
+
+DeltaRecorder::~DeltaRecorder()
+{
+    close();
+}
+
+bool DeltaRecorder::open(const std::string& aPath, int aHalfSide)
+{
+    close();
+    myFile = fopen(aPath.c_str(), "wb");
+    if(nullptr == myFile)
+        return false;
+    myHalfSide = aHalfSide;
+    myBytes.clear();
+    writeStreamHeader(aHalfSide, myBytes);
+    fwrite(myBytes.data(), 1, myBytes.size(), myFile);
+    return true;
+}
+
+void DeltaRecorder::close()
+{
+    if(nullptr != myFile)
+    {
+        fclose(myFile);
+        myFile = nullptr;
+    }
+}
+
+void DeltaRecorder::writeKeyframe(uint64_t aGeneration, const std::vector<sf::Vector2i>& someCells)
+{
+    ChangeList changes;
+    changes.births = someCells;
+    writeRecord(aGeneration, true, changes);
+}
+
+void DeltaRecorder::writeDelta(uint64_t aGeneration, const ChangeList& someChanges)
+{
+    writeRecord(aGeneration, false, someChanges);
+}
+
+void DeltaRecorder::writeRecord(uint64_t aGeneration, bool isKeyframe, const ChangeList& someChanges)
+{
+    if(nullptr == myFile)
+        return;
+    myBytes.clear();
+    writeStreamRecord(aGeneration, isKeyframe, someChanges, myHalfSide, myBytes);
+    fwrite(myBytes.data(), 1, myBytes.size(), myFile);
+}
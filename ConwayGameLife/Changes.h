@@ -0,0 +1,80 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Cells that were born and died in one generation, or edited
+/// </summary>
+struct ChangeList
+{
+    std::vector<sf::Vector2i> births;
+    std::vector<sf::Vector2i> deaths;
+
+    void clear()
+    {
+        births.clear();
+        deaths.clear();
+    }
+    bool empty() const { return births.empty() && deaths.empty(); }
+};
+
+/// <summary>
+/// Append a change list in compact form. Each list is cut into runs of cells one below the other,
+/// every run stored as varints: the column step, then the row (from the last run's end within a column),
+/// then the run length. Cells are shifted by anOffset so they are never negative.
+/// </summary>
+/// <param name="someChanges">Both lists sorted by column then row, as processCore emits them</param>
+void encodeChanges(const ChangeList& someChanges, int anOffset, std::vector<uint8_t>& outBytes);
+
+/// <summary>
+/// Read back a change list written by encodeChanges
+/// </summary>
+/// <param name="ioCursor">Moved past the list</param>
+/// <returns>False on truncated or malformed input</returns>
+bool decodeChanges(const uint8_t*& ioCursor, const uint8_t* anEnd, int anOffset, ChangeList& outChanges);
+
+void writeVarint(uint64_t aValue, std::vector<uint8_t>& outBytes);
+bool readVarint(const uint8_t*& ioCursor, const uint8_t* anEnd, uint64_t& outValue);
+
+/// <summary>
+/// Delta stream, shared by recordings and the broadcast server. "LIFEDLTA" magic and the world side,
+/// then per record the generation, a keyframe flag and an encoded change list. A keyframe holds every
+/// live cell as births on an empty world, so playback can start at any of them.
+/// Cells are world tiles, from -side / 2 to side / 2 - 1.
+/// </summary>
+void writeStreamHeader(int aHalfSide, std::vector<uint8_t>& outBytes);
+bool readStreamHeader(const uint8_t*& ioCursor, const uint8_t* anEnd, int& outHalfSide);
+void writeStreamRecord(uint64_t aGeneration, bool isKeyframe, const ChangeList& someChanges, int aHalfSide,
+                       std::vector<uint8_t>& outBytes);
+/// <returns>False on a truncated record, the cursor is left alone then</returns>
+bool readStreamRecord(const uint8_t*& ioCursor, const uint8_t* anEnd, int aHalfSide, uint64_t& outGeneration, bool& outIsKeyframe,
+                      ChangeList& outChanges);
+
+/// <summary>
+/// Delta stream written to a file
+/// </summary>
+class DeltaRecorder
+{
+public:
+    DeltaRecorder() = default;
+    DeltaRecorder(const DeltaRecorder&) = delete;
+    DeltaRecorder& operator=(const DeltaRecorder&) = delete;
+    ~DeltaRecorder();
+
+    /// <param name="aHalfSide">Half length of the torus, cells range from -aHalfSide to aHalfSide - 1</param>
+    bool open(const std::string& aPath, int aHalfSide);
+    void close();
+    bool isOpen() const { return nullptr != myFile; }
+    void writeKeyframe(uint64_t aGeneration, const std::vector<sf::Vector2i>& someCells);
+    void writeDelta(uint64_t aGeneration, const ChangeList& someChanges);
+
+private:
+    void writeRecord(uint64_t aGeneration, bool isKeyframe, const ChangeList& someChanges);
+
+    FILE* myFile = nullptr;
+    int myHalfSide = 0;
+    std::vector<uint8_t> myBytes;
+};
@@ -1,60 +1,30 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
 #include <algorithm>
-#include <set>
-
-struct TileComparator
-{
-    bool operator() (const sf::Vector2i& lhs, const sf::Vector2i& rhs) const
-    {
-        return lhs.x < rhs.x || lhs.x == rhs.x && lhs.y < rhs.y;
-    }
-};
-
-typedef std::set<sf::Vector2i, TileComparator> TileSet;
-
-/// <summary>
-/// Wrap the world up
-/// </summary>
-/// <param name="anInteger"></param>
-/// <param name="aModulo">The half length</param>
-/// <returns></returns>
-static int wrapInt(int anInteger, int aModulo)
-{
-    return (anInteger + 3 * aModulo) % (2 * aModulo) - aModulo;
-}
-
-/// <summary>
-/// Get the grid lines positions
-/// </summary>
-/// <param name="anOrigin"></param>
-/// <param name="aSize"></param>
-/// <param name="aSpacing"></param>
-/// <param name="outArray">The output array of lines</param>
-static void fillVerticeArray(const sf::Vector2f& anOrigin, const sf::Vector2f& aSize, float aSpacing, sf::VertexArray& outArray)
-{
-    int numHLines = aSize.y / aSpacing + 1, numVLines = aSize.x / aSpacing + 1;
-    outArray.resize(2 * (numHLines + numVLines));
-    int numoutArray = 0;
-    for(int i = 0; i < numHLines; i++)
-    {
-        outArray[numoutArray].position.x = anOrigin.x;
-        outArray[numoutArray].position.y = anOrigin.y + i * aSpacing;
-        ++numoutArray;
-        outArray[numoutArray].position.x = anOrigin.x + aSize.x;
-        outArray[numoutArray].position.y = anOrigin.y + i * aSpacing;
-        ++numoutArray;
-    }
-    for(int i = 0; i < numVLines; i++)
-    {
-        outArray[numoutArray].position.x = anOrigin.x + i * aSpacing;
-        outArray[numoutArray].position.y = anOrigin.y;
-        ++numoutArray;
-        outArray[numoutArray].position.x = anOrigin.x + i * aSpacing;
-        outArray[numoutArray].position.y = anOrigin.y + aSize.y;
-        ++numoutArray;
-    }
-}
+#include <cassert>
+#include <thread>
+#include "Benchmark.h"
+#include "Broadcast.h"
+#include "Census.h"
+#include "Changes.h"
+#include "DiffTest.h"
+#include "FastForward.h"
+#include "FixedGrid.h"
+#include "FrameExporter.h"
+#include "FramePacer.h"
+#include "GridLines.h"
+#include "Hensel.h"
+#include "LargerThanLife.h"
+#include "Lenia.h"
+#include "Life3D.h"
+#include "LifeStats.h"
+#include "Log.h"
+#include "MapServer.h"
+#include "PopulationPyramid.h"
+#include "SoupSearch.h"
+#include "TileBuffer.h"
+#include "TileSet.h"
+#include "Viewer.h"
 
 /// <summary>
 /// Transfer window coordinate to view coordinate
@@ -96,82 +66,111 @@ static bool pointSanityCheck(const sf::Vector2<T>& aPoint,
         && aPoint.y >= aCenter.y - aHalfRange.y && aPoint.y < aCenter.y + aHalfRange.y;
 }
 
-static const unsigned char kSideLength = 30;
-
-static int getNumOfLiveNeighbors(const sf::Vector2i& aTile, const TileSet& someTiles)
+/// <summary>
+/// Jump the editor tiles ahead, letting the board move between engines on the way
+/// </summary>
+/// <param name="someLiveTiles"></param>
+/// <param name="aGenerations"></param>
+/// <param name="aHalfSide"></param>
+static void fastForwardTiles(TileSet& someLiveTiles, uint64_t aGenerations, int aHalfSide)
 {
-    int result = 0;
-    auto tempTile = aTile;
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y - 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y + 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-
-    tempTile.x = wrapInt(aTile.x - 1, kSideLength);
-    tempTile.y = aTile.y;
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y - 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y + 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-
-    tempTile.x = wrapInt(aTile.x + 1, kSideLength);
-    tempTile.y = aTile.y;
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y - 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    tempTile.y = wrapInt(aTile.y + 1, kSideLength);
-    if(someTiles.end() != someTiles.find(tempTile)) ++result;
-    return result;
+    const sf::Vector2i offset(aHalfSide, aHalfSide);
+    std::vector<sf::Vector2i> cells;
+    for(auto& tile : someLiveTiles)
+        cells.push_back(tile + offset);
+    auto engine = createEngine(pickInitialEngine(cells.size(), 2 * aHalfSide), 2 * aHalfSide);
+    engine->load(cells);
+    fastForward(engine, aGenerations);
+    engine->save(cells);
+    someLiveTiles.clear();
+    for(auto& cell : cells)
+        someLiveTiles.insert(cell - offset);
 }
 
-static void setTileLiveness(const sf::Vector2i& aTile, TileSet& someTiles, bool isLive)
+/// <summary>
+/// One generation on the compiled in grid of the world's side, the tiles, pyramid and stats follow its changes
+/// </summary>
+/// <param name="outStats">Optional, filled like processCore does</param>
+static void stepFixed(LifeEngine& ioEngine, TileSet& someLiveTiles, GenerationStats* outStats, int aHalfSide,
+                      PopulationPyramid& ioPyramid, ChangeList& outChanges)
 {
-    if(isLive)
+    ioEngine.step(1);
+    // A step always leaves the generation before it behind, so the engine can tell what changed
+    const bool hasChanges = ioEngine.getChanges(outChanges);
+    assert(hasChanges);
+    (void)hasChanges;
+    const sf::Vector2i offset(aHalfSide, aHalfSide);
+    for(auto& tile : outChanges.deaths)
+    {
+        tile -= offset;
+        someLiveTiles.erase(tile);
+        ioPyramid.add(tile.x + aHalfSide, tile.y + aHalfSide, -1);
+    }
+    for(auto& tile : outChanges.births)
     {
-        someTiles.insert(aTile);
+        tile -= offset;
+        someLiveTiles.insert(tile);
+        ioPyramid.add(tile.x + aHalfSide, tile.y + aHalfSide, 1);
     }
-    else
+    if(outStats)
     {
-        const auto& it = someTiles.find(aTile);
-        if(someTiles.end() != it)
-            someTiles.erase(it);
+        // A popcount over the engine's words, not another pass over the tiles
+        ioEngine.sample(*outStats);
+        outStats->births = outChanges.births.size();
+        outStats->deaths = outChanges.deaths.size();
+        if(outStats->population)
+        {
+            outStats->minX -= aHalfSide;
+            outStats->maxX -= aHalfSide;
+            outStats->minY -= aHalfSide;
+            outStats->maxY -= aHalfSide;
+        }
     }
 }
 
 /// <summary>
-/// Extend the boundary to include all potential live tiles
+/// Shade one texel per pyramid block inside the view, so the cost follows the screen size instead of the population
 /// </summary>
-/// <returns></returns>
-static void getProcessingTiles(const TileSet& someTiles, TileSet& someBoundaryTiles)
+/// <param name="aLevel">Pyramid level, blocks of 2^aLevel tiles</param>
+/// <param name="ioTexture">Reused between frames, grows when needed</param>
+/// <param name="ioPixels">Reused between frames</param>
+static void drawPyramid(sf::RenderTarget& aTarget, const sf::View& aView, const PopulationPyramid& aPyramid, int aLevel,
+                        int aHalfSide, float aSpacing, sf::Texture& ioTexture, std::vector<sf::Uint8>& ioPixels)
 {
-    for(auto& tile : someTiles)
+    const float blockSize = aSpacing * (1 << aLevel);
+    const float worldLeft = -aHalfSide * aSpacing;
+    const int levelSide = aPyramid.getLevelSide(aLevel);
+    const sf::Vector2f viewMin = aView.getCenter() - aView.getSize() / 2.f, viewMax = aView.getCenter() + aView.getSize() / 2.f;
+    int left = std::max(0, (int)floor((viewMin.x - worldLeft) / blockSize));
+    int top = std::max(0, (int)floor((viewMin.y - worldLeft) / blockSize));
+    int right = std::min(levelSide, (int)ceil((viewMax.x - worldLeft) / blockSize));
+    int bottom = std::min(levelSide, (int)ceil((viewMax.y - worldLeft) / blockSize));
+    if(right <= left || bottom <= top)
+        return;
+    unsigned width = right - left, height = bottom - top;
+    if(ioTexture.getSize().x < width || ioTexture.getSize().y < height)
+        ioTexture.create(std::max(width, ioTexture.getSize().x), std::max(height, ioTexture.getSize().y));
+    ioPixels.resize(4 * width * height);
+    const uint32_t* counts = aPyramid.getLevel(aLevel);
+    const float tilesPerBlock = (float)(1 << aLevel) * (1 << aLevel);
+    sf::Uint8* pixel = ioPixels.data();
+    for(int y = top; y < bottom; y++)
     {
-        auto tempTile = tile;
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y - 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y + 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
-
-        tempTile.x = wrapInt(tile.x - 1, kSideLength);
-        tempTile.y = tile.y;
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y - 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y + 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
-
-        tempTile.y = tile.y;
-        tempTile.x = wrapInt(tile.x + 1, kSideLength);
-        tempTile.y = tile.y;
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y - 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
-        tempTile.y = wrapInt(tile.y + 1, kSideLength);
-        someBoundaryTiles.insert(tempTile);
+        for(int x = left; x < right; x++)
+        {
+            uint32_t count = counts[y * levelSide + x];
+            // Any life at all stays visible
+            sf::Uint8 shade = count ? (sf::Uint8)(64 + 191 * std::min(1.f, count / tilesPerBlock)) : 0;
+            pixel[0] = pixel[1] = pixel[2] = shade;
+            pixel[3] = 255;
+            pixel += 4;
+        }
     }
+    ioTexture.update(ioPixels.data(), width, height, 0, 0);
+    sf::Sprite sprite(ioTexture, sf::IntRect(0, 0, width, height));
+    sprite.setPosition(worldLeft + left * blockSize, worldLeft + top * blockSize);
+    sprite.setScale(blockSize, blockSize);
+    aTarget.draw(sprite);
 }
 
 enum GameState
@@ -181,42 +180,51 @@ enum GameState
     StepByStep // Press once, do once
 };
 
-/// <summary>
-/// Double buffering
-/// </summary>
-/// <param name=""></param>
-/// <param name="someLastLiveTiles"></param>
-static void processCore(TileSet& someLastLiveTiles, TileSet& someLiveTiles)
-{
-    std::swap(someLastLiveTiles, someLiveTiles);
-    someLiveTiles.clear();
-    TileSet boundaryTiles;
-    getProcessingTiles(someLastLiveTiles, boundaryTiles);
-    // Based on someLastLiveTiles, modify someLiveTiles
-    for(auto& tile : boundaryTiles)
-    {
-        int num = getNumOfLiveNeighbors(tile, someLastLiveTiles);
-        switch(num)
-        {
-        case 3:
-            setTileLiveness(tile, someLiveTiles, true);
-            break;
-        case 4:
-            setTileLiveness(tile, someLiveTiles, someLastLiveTiles.end() != someLastLiveTiles.find(tile));
-            break;
-        default:
-            setTileLiveness(tile, someLiveTiles, false);
-            break;
-        }
-    }
-}
-
-int main()
+int main(int argc, char* argv[])
 {
+    // Headless modes
+    if(argc > 1 && std::string("--soup-search") == argv[1])
+        return runSoupSearch(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--census") == argv[1])
+        return runCensus(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--fast-forward") == argv[1])
+        return runFastForward(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--bench") == argv[1])
+        return runBenchmark(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--profile") == argv[1])
+        return runProfile(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--diff-test") == argv[1])
+        return runDiffTest(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--serve") == argv[1])
+        return runBroadcast(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--map") == argv[1])
+        return runMapServer(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--view") == argv[1])
+        return runViewer(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--lenia") == argv[1])
+        return runContinuous(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--lenia-bench") == argv[1])
+        return runContinuousBenchmark(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--ltl") == argv[1])
+        return runLargerThanLife(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--hensel") == argv[1])
+        return runHensel(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--life3d") == argv[1])
+        return runLife3D(argc - 2, argv + 2);
+    if(argc > 1 && std::string("--life3d-bench") == argv[1])
+        return runLife3DBenchmark(argc - 2, argv + 2);
     const float kSpacing = 100.f;
     const float kScrollSpeed = 0.1f;
     const float kMinScale = 1.f, kMaxScale = 10.f;
-    const float kAutoPeriod = 0.1f;
+    // Automata speed limits, generations per second and per frame time budget in milliseconds
+    const double kDefaultRate = 10.0, kMinRate = 0.5, kMaxRate = 1e6;
+    const int kDefaultBudget = 12, kMinBudget = 1, kMaxBudget = 100, kBudgetStep = 2;
+    // Steps advance 2^exponent generations
+    const int kMaxStepExponent = 12;
+    const uint64_t kFastForwardGenerations = 1000;
+    // Frames drawn per second at most, and how often the frame rate and CPU use get logged with "--pace-report"
+    const int kFrameRate = 60;
+    const sf::Time kReportPeriod = sf::seconds(5.f);
     const std::string kStrTitle = "Conway's Game of Life";
     static float ourWinWidth = 800.f, ourWinHeight = 600.f;
     sf::RenderWindow window(sf::VideoMode (ourWinWidth, ourWinHeight), kStrTitle);
@@ -233,14 +241,125 @@ int main()
     bool hasPlaced = false;
     sf::Vector2i lastChangedTile;
     float autoTimestamp = 0.f;
+    // Generations owed to the fixed rate that did not add up to a whole step yet
+    double generationDebt = 0.0;
+    static double ourGenerationsPerSecond = kDefaultRate;
+    // Turbo runs as many steps as fit in the frame budget instead of keeping a rate
+    static bool ourIsTurbo = false;
+    static int ourFrameBudget = kDefaultBudget;
+    static int ourStepExponent = 0;
     static float ourElapsedTime;
     sf::Clock clock;
+    // Optional per generation statistics, "--stats <file.csv|file.bin>"
+    StatsStream statsStream;
+    GenerationStats stats;
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(std::string("--stats") == argv[i] && !statsStream.open(argv[i + 1]))
+            LOG_ERROR("failed to open stats stream %s\n", argv[i + 1]);
+    }
+    GenerationStats* statsOut = statsStream.isOpen() ? &stats : nullptr;
+    // World size, "--side <even number>"
+    static int ourHalfSide = kSideLength;
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(std::string("--side") == argv[i] && atoi(argv[i + 1]) >= 2)
+            ourHalfSide = atoi(argv[i + 1]) / 2;
+    }
+    // Zoomed out views read block populations instead of tiles
+    PopulationPyramid pyramid;
+    pyramid.resize(2 * ourHalfSide);
+    sf::Texture pyramidTexture;
+    std::vector<sf::Uint8> pyramidPixels;
+    // Live tiles stay on the GPU and follow each generation's changes
+    TileBuffer tileBuffer(kSpacing);
+    // Grid lines stay on the GPU too, rebuilt when the view leaves them
+    GridLines gridLines(kSpacing);
+    ChangeList changes;
+    // Optional delta recording, "--record <file>"
+    DeltaRecorder recorder;
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(std::string("--record") == argv[i] && !recorder.open(argv[i + 1], ourHalfSide))
+            LOG_ERROR("failed to open recording %s\n", argv[i + 1]);
+    }
+    // Optional picture export, "--export <file.gif | png prefix>" with "--export-every <generations>",
+    // "--export-wait" holds the generations back when the encoders fall behind instead of dropping frames
+    const int kExportQueueLength = 8;
+    FrameExporter exporter;
+    uint64_t exportEvery = 1;
+    bool isExportWaiting = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::string("--export-wait") == argv[i])
+            isExportWaiting = true;
+        if(std::string("--export-every") == argv[i] && i + 1 < argc && atoi(argv[i + 1]) >= 1)
+            exportEvery = (uint64_t)atoi(argv[i + 1]);
+    }
+    // One core is left to the simulation
+    const unsigned numEncoders = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(std::string("--export") == argv[i] && !exporter.open(argv[i + 1], ourHalfSide, numEncoders, kExportQueueLength, isExportWaiting))
+            LOG_ERROR("failed to open export %s\n", argv[i + 1]);
+    }
+    // Set after edits, the recording restarts from a keyframe before the next generation
+    bool needsKeyframe = true;
+    // Worlds of a compiled in size step on the fixed grid instead of the tile set, reloaded after edits
+    std::unique_ptr<LifeEngine> fixedEngine = createFixedEngine(2 * ourHalfSide);
+    bool isFixedStale = true;
+    auto advance = [&](uint64_t aGenerations)
+    {
+        if(recorder.isOpen() && needsKeyframe)
+            recorder.writeKeyframe(stats.generation, std::vector<sf::Vector2i>(liveTiles.begin(), liveTiles.end()));
+        needsKeyframe = false;
+        if(fixedEngine && isFixedStale)
+        {
+            std::vector<sf::Vector2i> cells;
+            for(auto& tile : liveTiles)
+                cells.push_back(tile + sf::Vector2i(ourHalfSide, ourHalfSide));
+            fixedEngine->load(cells);
+            isFixedStale = false;
+        }
+        for(uint64_t i = 0; i < aGenerations; i++)
+        {
+            if(fixedEngine)
+                stepFixed(*fixedEngine, liveTiles, statsOut, ourHalfSide, pyramid, changes);
+            else
+                processCore(lastLiveTiles, liveTiles, statsOut, ourHalfSide, &pyramid, &changes);
+            if(statsOut)
+                std::copy(pyramid.getDensity(), pyramid.getDensity() + kNumDensityBins, stats.density);
+            ++stats.generation;
+            statsStream.write(stats);
+            tileBuffer.apply(changes);
+            recorder.writeDelta(stats.generation, changes);
+            if(exporter.isOpen() && 0 == stats.generation % exportEvery)
+                exporter.submit(stats.generation, liveTiles, pyramid);
+        }
+    };
+    FramePacer pacer(kFrameRate);
+    // The frame rate and CPU report is logged only when asked for, "--pace-report"
+    bool isPaceReported = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::string("--pace-report") == argv[i])
+            isPaceReported = true;
+    }
+    // Set by anything that changes the picture, frames are only drawn then
+    bool needsRedraw = true;
+    std::string title;
     while(window.isOpen())
     {
-        ourElapsedTime = clock.getElapsedTime().asSeconds();
+        // Nothing moves on its own outside Automata, so once the picture is current block until the next event
+        const bool isIdle = GameState::Automata != gameState && !needsRedraw;
         sf::Event event;
-        while(window.pollEvent(event))
+        bool hasEvent = isIdle ? window.waitEvent(event) : window.pollEvent(event);
+        ourElapsedTime = clock.getElapsedTime().asSeconds();
+        for(; hasEvent; hasEvent = window.pollEvent(event))
         {
+            // The pointer moving on its own changes nothing on screen
+            if(sf::Event::MouseMoved != event.type || ourMouseRightHold || ourMouseLeftHold)
+                needsRedraw = true;
             if(event.type == sf::Event::Closed)
             {
                 window.close();
@@ -256,15 +375,17 @@ int main()
             {
                 float scale = 1 - event.mouseWheelScroll.delta * kScrollSpeed;
                 float finalScale = ourScale * scale;
+                // Big worlds may zoom out until they fit the window
+                float maxScale = std::max(kMaxScale, 2.f * ourHalfSide * kSpacing / std::min(ourWinWidth, ourWinHeight));
                 if(finalScale < kMinScale)
                 {
                     finalScale = kMinScale;
                     scale = kMinScale / ourScale;
                 }
-                else if(finalScale > kMaxScale)
+                else if(finalScale > maxScale)
                 {
-                    finalScale = kMaxScale;
-                    scale = kMaxScale / ourScale;
+                    finalScale = maxScale;
+                    scale = maxScale / ourScale;
                 }
                 auto mousePos = sf::Mouse::getPosition(window);
                 auto p2Center = win2View(sf::Vector2f(mousePos), sf::Vector2f(ourWinWidth, ourWinHeight));
@@ -275,14 +396,14 @@ int main()
                 view.setCenter(view.getCenter() + sf::Vector2f(sizeOffset.x * p2Center.x, sizeOffset.y * p2Center.y));
                 window.setView(view);
                 ourScale = finalScale;
-                printf("scolled global scale: %.3f\n", ourScale);
+                LOG_DEBUG("scolled global scale: %.3f\n", ourScale);
             }
             if(event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Right)
             {
                 ourMouseRightHold = true;
                 ourMousePressedX = event.mouseButton.x;
                 ourMousePressedY = event.mouseButton.y;
-                printf("right clicked pos x: %.3f, y: %.3f\n", ourMousePressedX, ourMousePressedY);
+                LOG_DEBUG("right clicked pos x: %.3f, y: %.3f\n", ourMousePressedX, ourMousePressedY);
             }
             if(event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Right)
                 ourMouseRightHold = false;
@@ -294,7 +415,7 @@ int main()
                 window.setView(view);
                 ourMousePressedX = event.mouseMove.x;
                 ourMousePressedY = event.mouseMove.y;
-                printf("moved center x: %.3f, y: %.3f\n", view.getCenter().x, view.getCenter().y);
+                LOG_DEBUG("moved center x: %.3f, y: %.3f\n", view.getCenter().x, view.getCenter().y);
             }
             if(event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
                 ourMouseLeftHold = true;
@@ -312,6 +433,11 @@ int main()
                     {
                         lastLiveTiles.clear();
                         liveTiles.clear();
+                        pyramid.clear();
+                        tileBuffer.reset(liveTiles);
+                        needsKeyframe = true;
+                        isFixedStale = true;
+                        stats.generation = 0;
                     }
                     break;
                 case sf::Keyboard::Escape:
@@ -328,6 +454,8 @@ int main()
                     case Editor:
                     case StepByStep:
                         gameState = GameState::Automata;
+                        autoTimestamp = ourElapsedTime;
+                        generationDebt = 0.0;
                         break;
                     case Automata:
                         gameState = GameState::StepByStep;
@@ -341,6 +469,44 @@ int main()
                     gameState = GameState::StepByStep;
                     ourDoNextStep = true;
                     break;
+                case sf::Keyboard::T:
+                    ourIsTurbo = !ourIsTurbo;
+                    LOG_INFO("turbo %s\n", ourIsTurbo ? "on" : "off");
+                    break;
+                case sf::Keyboard::Up:
+                case sf::Keyboard::Down:
+                {
+                    const bool isFaster = sf::Keyboard::Up == event.key.code;
+                    if(ourIsTurbo)
+                    {
+                        ourFrameBudget = std::max(kMinBudget, std::min(kMaxBudget, ourFrameBudget + (isFaster ? kBudgetStep : -kBudgetStep)));
+                        LOG_INFO("frame budget %d ms\n", ourFrameBudget);
+                    }
+                    else
+                    {
+                        ourGenerationsPerSecond = std::max(kMinRate, std::min(kMaxRate, ourGenerationsPerSecond * (isFaster ? 2.0 : 0.5)));
+                        LOG_INFO("rate %g generations/s\n", ourGenerationsPerSecond);
+                    }
+                    break;
+                }
+                case sf::Keyboard::LBracket:
+                case sf::Keyboard::RBracket:
+                    ourStepExponent = std::max(0, std::min(kMaxStepExponent, ourStepExponent + (sf::Keyboard::RBracket == event.key.code ? 1 : -1)));
+                    LOG_INFO("step 2^%d generations\n", ourStepExponent);
+                    break;
+                case sf::Keyboard::F:
+                    if(GameState::Automata != gameState)
+                    {
+                        fastForwardTiles(liveTiles, kFastForwardGenerations, ourHalfSide);
+                        pyramid.clear();
+                        for(auto& tile : liveTiles)
+                            pyramid.add(tile.x + ourHalfSide, tile.y + ourHalfSide, 1);
+                        tileBuffer.reset(liveTiles);
+                        needsKeyframe = true;
+                        isFixedStale = true;
+                        stats.generation += kFastForwardGenerations;
+                    }
+                    break;
                 default:
                     break;
                 }
@@ -354,25 +520,26 @@ int main()
             strGameState = " (Editor)";
             break;
         case Automata:
-            strGameState = " (Automata)";
+        {
+            char speed[64];
+            if(ourIsTurbo)
+                snprintf(speed, sizeof(speed), " (Automata, turbo %d ms/frame, step 2^%d)", ourFrameBudget, ourStepExponent);
+            else
+                snprintf(speed, sizeof(speed), " (Automata, %g gen/s, step 2^%d)", ourGenerationsPerSecond, ourStepExponent);
+            strGameState = speed;
             break;
+        }
         case StepByStep:
             strGameState = " (StepByStep)";
             break;
         default:
             break;
         }
-        window.setTitle(kStrTitle + strGameState);
-        // Draw grid
-        sf::VertexArray verticeArray;
-        verticeArray.setPrimitiveType(sf::Lines);
-        float left = std::max(view.getCenter().x - view.getSize().x / 2.f, -kSideLength * kSpacing);
-        float top = std::max(view.getCenter().y - view.getSize().y / 2.f, -kSideLength * kSpacing);
-        float width = std::min(view.getCenter().x + view.getSize().x / 2.f + kSpacing, kSideLength * kSpacing) - left;
-        float height = std::min(view.getCenter().y + view.getSize().y / 2.f + kSpacing, kSideLength * kSpacing) - top;
-        fillVerticeArray(sf::Vector2f(floor(left / kSpacing) * kSpacing, floor(top / kSpacing) * kSpacing),
-                         sf::Vector2f(ceil(width / kSpacing) * kSpacing, ceil(height / kSpacing) * kSpacing),
-                         kSpacing, verticeArray);
+        if(title != kStrTitle + strGameState)
+        {
+            title = kStrTitle + strGameState;
+            window.setTitle(title);
+        }
         if(GameState::Editor == gameState)
         {
             if(ourMouseLeftHold)
@@ -380,22 +547,31 @@ int main()
                 sf::Vector2f pos = view2World(win2View(sf::Vector2f(sf::Mouse::getPosition(window)),
                                               sf::Vector2f(ourWinWidth, ourWinHeight)), view);
                 sf::Vector2i tile(floor(pos.x / kSpacing), floor(pos.y / kSpacing));
-                if(pointSanityCheck(tile, sf::Vector2i(kSideLength, kSideLength)))
+                if(pointSanityCheck(tile, sf::Vector2i(ourHalfSide, ourHalfSide)))
                 {
                     if(tileComparator(lastChangedTile, tile) || tileComparator(tile, lastChangedTile) || !hasPlaced)
                     {
+                        changes.clear();
                         auto it = liveTiles.find(tile);
                         if(it != liveTiles.end())
                         {
                             liveTiles.erase(it);
-                            printf("remove tile x: %d, y: %d\n", tile.x, tile.y);
+                            pyramid.add(tile.x + ourHalfSide, tile.y + ourHalfSide, -1);
+                            changes.deaths.push_back(tile);
+                            LOG_DEBUG("remove tile x: %d, y: %d\n", tile.x, tile.y);
                         }
                         else
                         {
                             liveTiles.insert(tile);
-                            printf("new tile x: %d, y: %d\n", tile.x, tile.y);
+                            pyramid.add(tile.x + ourHalfSide, tile.y + ourHalfSide, 1);
+                            changes.births.push_back(tile);
+                            LOG_DEBUG("new tile x: %d, y: %d\n", tile.x, tile.y);
                         }
+                        tileBuffer.apply(changes);
+                        needsKeyframe = true;
+                        isFixedStale = true;
                         hasPlaced = true;
+                        needsRedraw = true;
                     }
                     lastChangedTile = tile;
                 }
@@ -403,30 +579,58 @@ int main()
         }
         else if(GameState::Automata == gameState)
         {
-            if(ourElapsedTime - autoTimestamp > kAutoPeriod)
+            // Whole steps while they are owed and the frame budget lasts, only the last generation gets drawn.
+            // The budget is checked between steps, so one long step may overrun it.
+            const uint64_t stepSize = 1ULL << ourStepExponent;
+            generationDebt += (ourElapsedTime - autoTimestamp) * ourGenerationsPerSecond;
+            autoTimestamp = ourElapsedTime;
+            sf::Clock frameClock;
+            while((ourIsTurbo || generationDebt >= stepSize) && frameClock.getElapsedTime() < sf::milliseconds(ourFrameBudget))
             {
-                processCore(lastLiveTiles, liveTiles);
-                autoTimestamp = ourElapsedTime;
+                advance(stepSize);
+                generationDebt -= stepSize;
+                needsRedraw = true;
             }
+            // What did not fit is dropped instead of piling up into later frames
+            generationDebt = std::max(0.0, std::min(generationDebt, (double)stepSize));
         }
         else if(GameState::StepByStep == gameState)
         {
             if(sf::Keyboard::isKeyPressed(sf::Keyboard::N) && ourDoNextStep)
             {
-                processCore(lastLiveTiles, liveTiles);
+                advance(1ULL << ourStepExponent);
                 ourDoNextStep = false;
+                needsRedraw = true;
             }
         }
-        // Core drawing
-        window.clear();
-        window.draw(verticeArray);
-        for(auto& tile : liveTiles)
+        const bool hasDrawn = needsRedraw;
+        if(needsRedraw)
         {
-            sf::RectangleShape tileShape(sf::Vector2f(kSpacing, kSpacing));
-            tileShape.setPosition(sf::Vector2f(tile) * kSpacing);
-            window.draw(tileShape);
+            // Core drawing
+            window.clear();
+            gridLines.draw(window, view, ourHalfSide);
+            float tilePixels = kSpacing / ourScale;
+            if(tilePixels < 1.f)
+            {
+                int level = std::min((int)ceil(log2(1.f / tilePixels)), pyramid.getNumLevels() - 1);
+                drawPyramid(window, view, pyramid, std::max(level, 1), ourHalfSide, kSpacing, pyramidTexture, pyramidPixels);
+            }
+            else
+            {
+                // Only the chunks inside the view, each uploading just the slots the last generations touched
+                tileBuffer.draw(window);
+            }
+            window.display();
+            pacer.countFrame();
+            needsRedraw = false;
         }
-        window.display();
+        // Frames come no faster than the frame rate and Automata wakes at that rate to see if a generation is due.
+        // Turbo is paced by its step budget instead.
+        const bool isTurbo = GameState::Automata == gameState && ourIsTurbo;
+        if(!isTurbo && (hasDrawn || GameState::Automata == gameState))
+            pacer.wait();
+        if(isPaceReported)
+            pacer.report(kReportPeriod);
     }
     return 0;
 }
\ No newline at end of file
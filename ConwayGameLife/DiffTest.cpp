@@ -0,0 +1,598 @@
+#include "DiffTest.h"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "BatchGrid.h"
+#include "BitGrid.h"
+#include "BitOps.h"
+#include "Changes.h"
+#include "FixedGrid.h"
+#include "Hensel.h"
+#include "LargerThanLife.h"
+#include "LifeEngine.h"
+#include "LifeStats.h"
+#include "Log.h"
+#include "Pattern.h"
+#include "TileSet.h"
+
+// Board sides tried, odd ones and ones either side of a word or a power of two included
+static const int kSides[] = { 2, 3, 4, 5, 7, 8, 16, 30, 31, 60, 63, 64, 65, 100, 127, 128, 129, 256 };
+// Every this many cases runs on a 1024 board, sparse patterns only and a quarter of the generations
+static const int kLargeCaseEvery = 16;
+static const int kLargeSide = 1024;
+// Every this many cases runs ten times longer, on boards up to kMaxLongSide
+static const int kLongCaseEvery = 8;
+static const int kMaxLongSide = 128;
+// Soups fill the whole board up to this side, beyond they are patches of at most this side
+static const int kMaxSoupSide = 64;
+// Runs the shrinker may spend on one failure
+static const int kMaxShrinkRuns = 4000;
+// Depth of the blocked step under test, small so a few generations cross several passes
+static const int kTestBlockDepth = 3;
+
+// Small patterns everything starts from, glider, LWSS, R-pentomino, blinker, block, beehive, diehard and the Gosper gun
+static const char* kCanonicalPatterns[] =
+{
+    "x = 3, y = 3\nbo$2bo$3o!",
+    "x = 5, y = 4\nbo2bo$o4b$o3bo$4o!",
+    "x = 3, y = 3\nb2o$2ob$bo!",
+    "x = 3, y = 1\n3o!",
+    "x = 2, y = 2\n2o$2o!",
+    "x = 4, y = 3\nb2o$o2bo$b2o!",
+    "x = 8, y = 3\n6bob$2o6b$bo3b3o!",
+    "x = 36, y = 9\n24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!"
+};
+
+/// <summary>
+/// Cell by cell B3/S23 with the neighbours wrapped by modulo, slow but obvious.
+/// The reference for odd sides, which processCore cannot express.
+/// </summary>
+class NaiveEngine : public LifeEngine
+{
+public:
+    explicit NaiveEngine(int aSide)
+        : mySide(aSide)
+        , myCells(aSide * aSide, 0)
+        , myNextCells(aSide * aSide, 0)
+    {
+    }
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return mySide; }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        std::fill(myCells.begin(), myCells.end(), 0);
+        for(auto& cell : someCells)
+            myCells[cell.y * mySide + cell.x] = 1;
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        outCells.clear();
+        for(int y = 0; y < mySide; y++)
+        {
+            for(int x = 0; x < mySide; x++)
+            {
+                if(myCells[y * mySide + x])
+                    outCells.push_back(sf::Vector2i(x, y));
+            }
+        }
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+        {
+            for(int y = 0; y < mySide; y++)
+            {
+                for(int x = 0; x < mySide; x++)
+                {
+                    int numNeighbours = 0;
+                    for(int dy = -1; dy <= 1; dy++)
+                    {
+                        for(int dx = -1; dx <= 1; dx++)
+                        {
+                            if(dx || dy)
+                                numNeighbours += myCells[(y + dy + mySide) % mySide * mySide + (x + dx + mySide) % mySide];
+                        }
+                    }
+                    myNextCells[y * mySide + x] = 3 == numNeighbours || (2 == numNeighbours && myCells[y * mySide + x]);
+                }
+            }
+            myCells.swap(myNextCells);
+        }
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        outStats.reset();
+        for(int y = 0; y < mySide; y++)
+        {
+            for(int x = 0; x < mySide; x++)
+            {
+                if(myCells[y * mySide + x])
+                {
+                    outStats.population++;
+                    outStats.include(x, y);
+                }
+            }
+        }
+    }
+
+private:
+    int mySide;
+    std::vector<uint8_t> myCells;
+    std::vector<uint8_t> myNextCells;
+};
+
+/// <summary>
+/// BitGrid without sleeping, or through the temporally blocked step
+/// </summary>
+class PlainBitsEngine : public LifeEngine
+{
+public:
+    PlainBitsEngine(int aSide, bool isBlocked) : myGrid(aSide, aSide), myIsBlocked(isBlocked) {}
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return myGrid.getWidth(); }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        myGrid.clear();
+        for(auto& cell : someCells)
+            myGrid.set(cell.x, cell.y, true);
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        saveWords(myGrid.getRow(0), myGrid.getWordsPerRow(), myGrid.getHeight(), outCells);
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        if(myIsBlocked)
+        {
+            myGrid.stepBlocked(aGenerations, kTestBlockDepth);
+            return;
+        }
+        for(uint64_t i = 0; i < aGenerations; i++)
+            myGrid.step();
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        sampleWords(myGrid.getRow(0), myGrid.getWordsPerRow(), myGrid.getHeight(), outStats);
+    }
+
+    bool getChanges(ChangeList& outChanges) const override { return myGrid.getChanges(outChanges); }
+
+private:
+    BitGrid myGrid;
+    bool myIsBlocked;
+};
+
+/// <summary>
+/// One lane of a BatchGrid, the other lanes hold random soups so any leak between lanes shows
+/// </summary>
+class BatchLaneEngine : public LifeEngine
+{
+public:
+    explicit BatchLaneEngine(int aSide)
+        : myBatch(aSide, aSide)
+        , myBoard(aSide, aSide)
+        , myLane(aSide % BatchGrid::kLanes)
+    {
+    }
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return myBatch.getWidth(); }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        std::mt19937_64 random(myBatch.getWidth());
+        for(int lane = 0; lane < BatchGrid::kLanes; lane++)
+        {
+            myBoard.clear();
+            if(lane == myLane)
+            {
+                for(auto& cell : someCells)
+                    myBoard.set(cell.x, cell.y, true);
+            }
+            else
+            {
+                for(int y = 0; y < myBoard.getHeight(); y++)
+                {
+                    uint64_t* row = myBoard.editRow(y);
+                    for(int i = 0; i < myBoard.getWordsPerRow(); i++)
+                        row[i] = random() & (i + 1 == myBoard.getWordsPerRow() ? myBoard.getTailMask() : ~0ULL);
+                }
+            }
+            myBatch.load(lane, myBoard);
+        }
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        myBatch.save(myLane, myBoard);
+        saveWords(myBoard.getRow(0), myBoard.getWordsPerRow(), myBoard.getHeight(), outCells);
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+            myBatch.step();
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        myBatch.save(myLane, myBoard);
+        sampleWords(myBoard.getRow(0), myBoard.getWordsPerRow(), myBoard.getHeight(), outStats);
+    }
+
+private:
+    BatchGrid myBatch;
+    // Scratch to move a lane in and out
+    mutable BitGrid myBoard;
+    int myLane;
+};
+
+/// <summary>
+/// A grid of one of the wider rule families set to B3/S23, so its fast path is held to processCore as well
+/// </summary>
+template<typename G>
+class RuleGridEngine : public LifeEngine
+{
+public:
+    RuleGridEngine(int aSide, G* aGrid)
+        : mySide(aSide)
+        , myGrid(aGrid)
+    {
+    }
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return mySide; }
+    void load(const std::vector<sf::Vector2i>& someCells) override { myGrid->load(someCells); }
+    void save(std::vector<sf::Vector2i>& outCells) const override { myGrid->save(outCells); }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+            myGrid->step();
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        std::vector<sf::Vector2i> cells;
+        myGrid->save(cells);
+        outStats.reset();
+        outStats.population = cells.size();
+        for(auto& cell : cells)
+            outStats.include(cell.x, cell.y);
+    }
+
+private:
+    int mySide;
+    std::unique_ptr<G> myGrid;
+};
+
+/// <summary>
+/// An engine checked against the reference
+/// </summary>
+struct Candidate
+{
+    const char* name;
+    bool (*isSupported)(int aSide);
+    std::unique_ptr<LifeEngine> (*create)(int aSide);
+    // Generations per step call, above one the engine is compared every so many generations
+    int stride;
+};
+
+static const Candidate kCandidates[] =
+{
+    { "dense bits, sleeping",
+      [](int) { return true; },
+      [](int aSide) { return createEngine(EngineType::DenseBits, aSide); }, 1 },
+    { "dense bits, plain",
+      [](int) { return true; },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new PlainBitsEngine(aSide, false)); }, 1 },
+    { "dense bits, blocked",
+      [](int) { return true; },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new PlainBitsEngine(aSide, true)); }, 7 },
+    { "fixed grid",
+      [](int aSide) { return (bool)createFixedEngine(aSide); },
+      [](int aSide) { return createFixedEngine(aSide); }, 1 },
+    { "quadtree",
+      [](int aSide) { return isEngineSupported(EngineType::QuadTree, aSide); },
+      [](int aSide) { return createEngine(EngineType::QuadTree, aSide); }, 1 },
+    { "quadtree, jumps",
+      [](int aSide) { return isEngineSupported(EngineType::QuadTree, aSide); },
+      [](int aSide) { return createEngine(EngineType::QuadTree, aSide); }, 13 },
+    { "batch lane",
+      [](int aSide) { return aSide <= 256; },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new BatchLaneEngine(aSide)); }, 1 },
+    { "hensel table",
+      [](int aSide) { return 0 == aSide % 64; },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new RuleGridEngine<HenselGrid>(aSide, new HenselGrid(aSide, aSide, HenselRule(), 1))); }, 1 },
+    // The default rule is "R1,C0,M0,S2..3,B3..3,NM", B3/S23 in Golly's notation
+    { "larger than life",
+      [](int aSide) { return aSide > 2; },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new RuleGridEngine<LtlGrid>(aSide, new LtlGrid(aSide, LtlRule(), 1))); }, 1 },
+    { "naive",
+      [](int aSide) { return aSide <= 256 && isEngineSupported(EngineType::SparseSet, aSide); },
+      [](int aSide) { return std::unique_ptr<LifeEngine>(new NaiveEngine(aSide)); }, 1 }
+};
+static const int kNumCandidates = sizeof(kCandidates) / sizeof(kCandidates[0]);
+
+/// <summary>
+/// processCore where it can run the side, the naive engine otherwise
+/// </summary>
+static std::unique_ptr<LifeEngine> createReference(int aSide)
+{
+    if(isEngineSupported(EngineType::SparseSet, aSide))
+        return createEngine(EngineType::SparseSet, aSide);
+    return std::unique_ptr<LifeEngine>(new NaiveEngine(aSide));
+}
+
+/// <summary>
+/// Sort the cells like a TileSet and hash them, engines save in their own order
+/// </summary>
+static uint64_t hashCells(std::vector<sf::Vector2i>& ioCells)
+{
+    std::sort(ioCells.begin(), ioCells.end(), TileComparator());
+    uint64_t hash = mix64(ioCells.size());
+    for(auto& cell : ioCells)
+        hash = mix64(hash ^ ((uint64_t)(uint32_t)cell.x << 32 | (uint32_t)cell.y));
+    return hash;
+}
+
+/// <summary>
+/// Births and deaths between two sorted boards
+/// </summary>
+static void diffCells(const std::vector<sf::Vector2i>& somePrevious, const std::vector<sf::Vector2i>& someCurrent, ChangeList& outChanges)
+{
+    outChanges.clear();
+    std::set_difference(someCurrent.begin(), someCurrent.end(), somePrevious.begin(), somePrevious.end(),
+                        std::back_inserter(outChanges.births), TileComparator());
+    std::set_difference(somePrevious.begin(), somePrevious.end(), someCurrent.begin(), someCurrent.end(),
+                        std::back_inserter(outChanges.deaths), TileComparator());
+}
+
+struct Mismatch
+{
+    int candidate;
+    uint64_t generation;
+    bool isChangeList; // The board matched but the reported births and deaths did not
+};
+
+/// <summary>
+/// Run the board through the reference and the candidates in lockstep, comparing the board hash
+/// whenever a candidate has stepped, and the births and deaths of candidates that report them.
+/// A candidate stops at its first mismatch.
+/// </summary>
+/// <param name="someCandidates">Indices into kCandidates</param>
+/// <param name="ioNumCompared">Optional, generations compared per candidate are added in</param>
+static void runCase(int aSide, const std::vector<sf::Vector2i>& someCells, uint64_t aGenerations,
+                    const std::vector<int>& someCandidates, std::vector<Mismatch>& outMismatches, uint64_t* ioNumCompared = nullptr)
+{
+    struct Runner
+    {
+        int candidate;
+        std::unique_ptr<LifeEngine> engine;
+        uint64_t generation;
+        bool isDone;
+    };
+    outMismatches.clear();
+    std::unique_ptr<LifeEngine> reference = createReference(aSide);
+    reference->load(someCells);
+    std::vector<Runner> runners;
+    for(int candidate : someCandidates)
+    {
+        runners.push_back(Runner{ candidate, kCandidates[candidate].create(aSide), 0, false });
+        runners.back().engine->load(someCells);
+    }
+    std::vector<sf::Vector2i> previous, current, cells;
+    reference->save(previous);
+    hashCells(previous);
+    ChangeList expected, changes;
+    for(uint64_t generation = 1; generation <= aGenerations && outMismatches.size() < runners.size(); generation++)
+    {
+        reference->step(1);
+        reference->save(current);
+        const uint64_t hash = hashCells(current);
+        bool hasExpected = false;
+        for(auto& runner : runners)
+        {
+            const int stride = kCandidates[runner.candidate].stride;
+            if(runner.isDone || (generation % stride && generation != aGenerations))
+                continue;
+            runner.engine->step(generation - runner.generation);
+            runner.generation = generation;
+            runner.engine->save(cells);
+            bool isMatch = hashCells(cells) == hash;
+            bool isChangeList = false;
+            if(isMatch && 1 == stride && runner.engine->getChanges(changes))
+            {
+                if(!hasExpected)
+                    diffCells(previous, current, expected);
+                hasExpected = true;
+                isChangeList = true;
+                isMatch = changes.births == expected.births && changes.deaths == expected.deaths;
+            }
+            if(ioNumCompared)
+                ioNumCompared[runner.candidate]++;
+            if(!isMatch)
+            {
+                outMismatches.push_back(Mismatch{ runner.candidate, generation, isChangeList });
+                runner.isDone = true;
+            }
+        }
+        previous.swap(current);
+    }
+}
+
+/// <summary>
+/// Delta debugging over the cells: drop chunks of them, halving the chunk size whenever no chunk can go,
+/// keeping every removal after which the candidate still fails. The generations shrink to the earliest failure each time.
+/// </summary>
+/// <param name="ioGenerations">The failing generation going in</param>
+static void shrink(int aSide, int aCandidate, std::vector<sf::Vector2i>& ioCells, uint64_t& ioGenerations, bool& ioIsChangeList)
+{
+    const std::vector<int> candidates(1, aCandidate);
+    std::vector<Mismatch> mismatches;
+    std::vector<sf::Vector2i> trial;
+    int numRuns = 0;
+    size_t chunk = std::max<size_t>(1, ioCells.size() / 2);
+    while(numRuns < kMaxShrinkRuns && !ioCells.empty())
+    {
+        bool hasRemoved = false;
+        for(size_t start = 0; start < ioCells.size() && numRuns < kMaxShrinkRuns;)
+        {
+            trial.assign(ioCells.begin(), ioCells.begin() + start);
+            trial.insert(trial.end(), ioCells.begin() + std::min(start + chunk, ioCells.size()), ioCells.end());
+            runCase(aSide, trial, ioGenerations, candidates, mismatches);
+            numRuns++;
+            if(mismatches.empty())
+            {
+                start += chunk;
+                continue;
+            }
+            ioCells.swap(trial);
+            ioGenerations = mismatches[0].generation;
+            ioIsChangeList = mismatches[0].isChangeList;
+            hasRemoved = true;
+        }
+        if(hasRemoved)
+            chunk = std::max<size_t>(1, std::min(chunk, ioCells.size() / 2));
+        else if(chunk > 1)
+            chunk /= 2;
+        else
+            break;
+    }
+}
+
+/// <summary>
+/// Copies of canonical patterns, each turned one of eight ways and placed anywhere or straddling an edge or a corner
+/// </summary>
+static void placeCanonical(int aSide, std::mt19937_64& ioRandom, std::vector<sf::Vector2i>& outCells)
+{
+    const int numPatterns = sizeof(kCanonicalPatterns) / sizeof(kCanonicalPatterns[0]);
+    const int numCopies = 1 + ioRandom() % 4;
+    std::vector<sf::Vector2i> pattern;
+    for(int i = 0; i < numCopies; i++)
+    {
+        parseRle(kCanonicalPatterns[ioRandom() % numPatterns], pattern);
+        const int orientation = ioRandom() % 8;
+        // Near the far edge so the pattern wraps over it, or anywhere
+        const int x = ioRandom() % 2 ? aSide - 1 - (int)(ioRandom() % 4) : (int)(ioRandom() % aSide);
+        const int y = ioRandom() % 2 ? aSide - 1 - (int)(ioRandom() % 4) : (int)(ioRandom() % aSide);
+        for(auto cell : pattern)
+        {
+            if(orientation & 1)
+                cell.x = -cell.x;
+            if(orientation & 2)
+                cell.y = -cell.y;
+            if(orientation & 4)
+                std::swap(cell.x, cell.y);
+            outCells.push_back(sf::Vector2i(((x + cell.x) % aSide + aSide) % aSide, ((y + cell.y) % aSide + aSide) % aSide));
+        }
+    }
+}
+
+/// <summary>
+/// Random soup over the whole board, or a patch of it wrapping over the edges on larger boards
+/// </summary>
+static void placeSoup(int aSide, std::mt19937_64& ioRandom, std::vector<sf::Vector2i>& outCells)
+{
+    const int width = aSide <= kMaxSoupSide ? aSide : 1 + (int)(ioRandom() % kMaxSoupSide);
+    const int height = aSide <= kMaxSoupSide ? aSide : 1 + (int)(ioRandom() % kMaxSoupSide);
+    const int left = ioRandom() % aSide, top = ioRandom() % aSide;
+    std::bernoulli_distribution isLive(std::uniform_real_distribution<double>(0.05, 0.6)(ioRandom));
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            if(isLive(ioRandom))
+                outCells.push_back(sf::Vector2i((left + x) % aSide, (top + y) % aSide));
+        }
+    }
+}
+
+int runDiffTest(int argc, char* argv[])
+{
+    const int numCases = argc > 0 ? atoi(argv[0]) : 200;
+    const uint64_t generations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100;
+    const uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+    if(numCases < 1 || generations < 1)
+    {
+        LOG_INFO("usage: --diff-test [cases] [generations] [seed]\n");
+        return 1;
+    }
+    std::mt19937_64 random(seed);
+    std::vector<uint8_t> hasFailed(kNumCandidates, 0);
+    std::vector<uint64_t> numCompared(kNumCandidates, 0);
+    std::vector<int> numRun(kNumCandidates, 0);
+    std::vector<sf::Vector2i> cells;
+    std::vector<int> candidates;
+    std::vector<Mismatch> mismatches;
+    for(int i = 0; i < numCases; i++)
+    {
+        const bool isLarge = (i + 1) % kLargeCaseEvery == 0;
+        const int side = isLarge ? kLargeSide : kSides[random() % (sizeof(kSides) / sizeof(kSides[0]))];
+        uint64_t caseGenerations = isLarge ? std::max<uint64_t>(1, generations / 4) : generations;
+        if((i + 1) % kLongCaseEvery == 0 && side <= kMaxLongSide)
+            caseGenerations *= 10;
+        cells.clear();
+        if(isLarge || random() % 2)
+            placeCanonical(side, random, cells);
+        else
+            placeSoup(side, random, cells);
+        std::sort(cells.begin(), cells.end(), TileComparator());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+        candidates.clear();
+        for(int candidate = 0; candidate < kNumCandidates; candidate++)
+        {
+            if(!hasFailed[candidate] && kCandidates[candidate].isSupported(side))
+            {
+                candidates.push_back(candidate);
+                numRun[candidate]++;
+            }
+        }
+        runCase(side, cells, caseGenerations, candidates, mismatches, numCompared.data());
+        for(auto& mismatch : mismatches)
+        {
+            const Candidate& candidate = kCandidates[mismatch.candidate];
+            hasFailed[mismatch.candidate] = 1;
+            LOG_ERROR("%s disagrees with the reference on its %s, %dx%d torus, %llu cells, generation %llu\n",
+                      candidate.name, mismatch.isChangeList ? "births and deaths" : "board", side, side,
+                      (unsigned long long)cells.size(), (unsigned long long)mismatch.generation);
+            std::vector<sf::Vector2i> shrunk = cells;
+            uint64_t failingGeneration = mismatch.generation;
+            bool isChangeList = mismatch.isChangeList;
+            shrink(side, mismatch.candidate, shrunk, failingGeneration, isChangeList);
+            GenerationStats bounds;
+            bounds.reset();
+            for(auto& cell : shrunk)
+                bounds.include(cell.x, cell.y);
+            LOG_INFO("shrunk to %llu cells failing on the %s at generation %llu, placed from (%d, %d):\n%s",
+                     (unsigned long long)shrunk.size(), isChangeList ? "births and deaths" : "board",
+                     (unsigned long long)failingGeneration, shrunk.empty() ? 0 : bounds.minX, shrunk.empty() ? 0 : bounds.minY,
+                     writeRle(shrunk).c_str());
+        }
+    }
+
+    int numFailed = 0;
+    for(int candidate = 0; candidate < kNumCandidates; candidate++)
+    {
+        numFailed += hasFailed[candidate];
+        LOG_INFO("%-24s %6d cases %10llu generations compared%s\n", kCandidates[candidate].name, numRun[candidate],
+                 (unsigned long long)numCompared[candidate], hasFailed[candidate] ? ", FAILED" : "");
+    }
+    LOG_INFO("%d cases, %d of %d engines failed\n", numCases, numFailed, kNumCandidates);
+    return numFailed ? 1 : 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/// <summary>
+/// Entry of the LifeDiffTest executable, "[cases] [generations] [seed]", and of "--diff-test" in the game. Runs random soups and canonical patterns,
+/// placed across the torus edges, on a range of sizes through processCore as the reference and through every
+/// other engine, comparing a hash of the board each generation. The first mismatch is shrunk to the fewest
+/// cells and generations that still fail and printed as RLE.
+/// </summary>
+/// <returns>0 when every engine agreed</returns>
+int runDiffTest(int argc, char* argv[]);
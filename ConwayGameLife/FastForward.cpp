@@ -0,0 +1,179 @@
+#include "FastForward.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include "Harness.h"
+#include "LifeStats.h"
+#include "Log.h"
+#include "Pattern.h"
+
+// Guesses for engines not measured yet, per live cell for the sparse set and per word for the dense bits
+static const double kSparseSecondsPerCell = 2e-7;
+static const double kDenseSecondsPerWord = 2e-9;
+// Below this density the sparse set starts
+static const double kSparseDensity = 0.01;
+// Another engine has to look this much cheaper, this many samples in a row, before the board moves
+static const double kSwitchRatio = 0.6;
+static const int kSwitchSamples = 2;
+// Cost of a generation on any engine with nothing to do, so an empty board never looks free
+static const double kStepFloorSeconds = 1e-7;
+static const uint64_t kFirstChunk = 16;
+static const uint64_t kMaxChunk = 4096;
+// Steady samples in a row before the quadtree is worth a try
+static const int kRegularSamples = 4;
+
+EngineType pickInitialEngine(uint64_t aPopulation, int aSide)
+{
+    double density = (double)aPopulation / ((double)aSide * aSide);
+    if(density < kSparseDensity && isEngineSupported(EngineType::SparseSet, aSide))
+        return EngineType::SparseSet;
+    return EngineType::DenseBits;
+}
+
+/// <summary>
+/// Population within 2% and bounding box within 2 cells of the last sample
+/// </summary>
+static bool isSteady(const GenerationStats& aLast, const GenerationStats& aCurrent)
+{
+    int64_t populationChange = (int64_t)aCurrent.population - (int64_t)aLast.population;
+    if(std::llabs(populationChange) > (int64_t)(aCurrent.population / 50 + 2))
+        return false;
+    return std::abs((aCurrent.maxX - aCurrent.minX) - (aLast.maxX - aLast.minX)) <= 2
+        && std::abs((aCurrent.maxY - aCurrent.minY) - (aLast.maxY - aLast.minY)) <= 2;
+}
+
+void fastForward(std::unique_ptr<LifeEngine>& ioEngine, uint64_t aGenerations)
+{
+    const int side = ioEngine->getSide();
+    const double numWords = (double)side * ((side + 63) / 64);
+    const double kUnknown = std::numeric_limits<double>::infinity();
+    double sparsePerCell = kSparseSecondsPerCell, densePerWord = kDenseSecondsPerWord;
+    uint64_t quadRetryAt = 0;
+    int numSteady = 0;
+    // Chunks run since the board last moved, and the engine that has been winning over it
+    int numChunks = 0;
+    EngineType candidate = ioEngine->getType();
+    int numWins = 0;
+    GenerationStats last, current;
+    ioEngine->sample(last);
+    LOG_INFO("fast-forward %llu generations, %dx%d, population %llu, starting on %s\n",
+           (unsigned long long)aGenerations, side, side, (unsigned long long)last.population,
+           getEngineName(ioEngine->getType()));
+    auto totalStart = std::chrono::steady_clock::now();
+    uint64_t done = 0, chunk = kFirstChunk;
+    std::vector<sf::Vector2i> cells;
+    while(done < aGenerations)
+    {
+        const uint64_t count = std::min(chunk, aGenerations - done);
+        auto start = std::chrono::steady_clock::now();
+        ioEngine->step(count);
+        const double measured = secondsSince(start) / count;
+        done += count;
+        numChunks++;
+        ioEngine->sample(current);
+        const EngineType type = ioEngine->getType();
+        switch(type)
+        {
+        case SparseSet:
+            sparsePerCell = measured / (double)std::max<uint64_t>(1, (last.population + current.population) / 2);
+            break;
+        case DenseBits:
+            densePerWord = measured / numWords;
+            break;
+        default:
+            break;
+        }
+        numSteady = isSteady(last, current) ? numSteady + 1 : 0;
+        if(QuadTree == type && 1 == numChunks)
+        {
+            // The first chunk fills an empty cache, the quadtree's worst case, so it is judged from the next one
+            chunk *= 2;
+            last = current;
+            continue;
+        }
+
+        double estimates[3];
+        estimates[SparseSet] = isEngineSupported(SparseSet, side) ? kStepFloorSeconds + sparsePerCell * current.population : kUnknown;
+        estimates[DenseBits] = kStepFloorSeconds + densePerWord * numWords;
+        estimates[QuadTree] = kUnknown;
+        // Not while backing off after the quadtree lost
+        if(isEngineSupported(QuadTree, side) && done >= quadRetryAt && numSteady >= kRegularSamples)
+            estimates[QuadTree] = kStepFloorSeconds; // Regular enough to try
+        estimates[type] = measured;
+        EngineType best = type;
+        for(int i = 0; i < 3; i++)
+        {
+            if(estimates[i] < estimates[best])
+                best = (EngineType)i;
+        }
+        if(best != type && estimates[best] < kSwitchRatio * measured)
+        {
+            numWins = best == candidate ? numWins + 1 : 1;
+            candidate = best;
+        }
+        else
+        {
+            numWins = 0;
+        }
+        if(numWins >= kSwitchSamples)
+        {
+            char steady[48] = "";
+            if(numSteady)
+                snprintf(steady, sizeof(steady), ", steady for %d samples", numSteady);
+            char expected[64];
+            if(QuadTree == best)
+                snprintf(expected, sizeof(expected), "untried on a regular pattern");
+            else
+                snprintf(expected, sizeof(expected), "%.3g us/gen expected", estimates[best] * 1e6);
+            LOG_INFO("gen %llu: %s -> %s, population %llu (density %.3f%%), box %dx%d%s, %.3g us/gen measured, %s\n",
+                   (unsigned long long)done, getEngineName(type), getEngineName(best),
+                   (unsigned long long)current.population, 100.0 * current.population / ((double)side * side),
+                   current.maxX - current.minX + 1, current.maxY - current.minY + 1, steady, measured * 1e6, expected);
+            if(QuadTree == type)
+            {
+                // Back off before trying the quadtree again
+                quadRetryAt = done * 2;
+            }
+            ioEngine->save(cells);
+            ioEngine = createEngine(best, side);
+            ioEngine->load(cells);
+            chunk = kFirstChunk;
+            numChunks = 0;
+            numWins = 0;
+        }
+        else if(QuadTree == type)
+        {
+            // Memoisation pays off more the further each call jumps
+            chunk *= 2;
+        }
+        else
+        {
+            chunk = std::min(chunk * 2, kMaxChunk);
+        }
+        last = current;
+    }
+    double seconds = secondsSince(totalStart);
+    LOG_INFO("reached generation %llu in %.3f s (%.3g gen/s), population %llu, on %s\n",
+           (unsigned long long)done, seconds, done / seconds, (unsigned long long)last.population,
+           getEngineName(ioEngine->getType()));
+}
+
+int runFastForward(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        LOG_INFO("usage: --fast-forward <generations> <side> <pattern.rle | density> [seed]\n");
+        return 1;
+    }
+    uint64_t generations = strtoull(argv[0], nullptr, 10);
+    int side = atoi(argv[1]);
+    std::vector<sf::Vector2i> cells;
+    makeBoard(argv[2], side, argc > 3 ? strtoull(argv[3], nullptr, 10) : 0, cells);
+    std::unique_ptr<LifeEngine> engine = createEngine(pickInitialEngine(cells.size(), side), side);
+    engine->load(cells);
+    fastForward(engine, generations);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "LifeEngine.h"
+
+/// <summary>
+/// Advance a board by aGenerations, sampling density, bounding box growth and step cost along the way
+/// and moving the board to whichever engine is expected to be fastest. Every switch is logged with its reason.
+/// </summary>
+/// <param name="ioEngine">Replaced when the board moves to another engine</param>
+void fastForward(std::unique_ptr<LifeEngine>& ioEngine, uint64_t aGenerations);
+
+/// <summary>
+/// Engine to start with, from the density alone
+/// </summary>
+EngineType pickInitialEngine(uint64_t aPopulation, int aSide);
+
+/// <summary>
+/// Command line entry, "--fast-forward <generations> <side> <pattern.rle | density> [seed]"
+/// </summary>
+int runFastForward(int argc, char* argv[]);
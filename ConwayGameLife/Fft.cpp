@@ -0,0 +1,152 @@
+#include "Fft.h"
+#include <algorithm>
+#include <cmath>
+#include "Parallel.h"
+
+typedef std::complex<float> Complex;
+
+/// <summary>
+/// Plain product, std::complex checks for infinities and NaNs on every multiply
+/// </summary>
+static inline Complex multiply(const Complex& aLeft, const Complex& aRight)
+{
+    return Complex(aLeft.real() * aRight.real() - aLeft.imag() * aRight.imag(),
+                   aLeft.real() * aRight.imag() + aLeft.imag() * aRight.real());
+}
+
+RealFft2D::RealFft2D(int aWidth, int aHeight, unsigned aNumThreads)
+    : myWidth(aWidth)
+    , myHeight(aHeight)
+    , myNumThreads(std::max(1u, aNumThreads))
+{
+    makePlan(aWidth, myRowPlan);
+    makePlan(aHeight, myColumnPlan);
+}
+
+void RealFft2D::makePlan(int aSize, Plan& outPlan)
+{
+    outPlan.size = aSize;
+    outPlan.bitReverse.resize(aSize);
+    int numBits = 0;
+    while((1 << numBits) < aSize)
+        numBits++;
+    for(int i = 0; i < aSize; i++)
+    {
+        int reversed = 0;
+        for(int bit = 0; bit < numBits; bit++)
+            reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+        outPlan.bitReverse[i] = reversed;
+    }
+    outPlan.twiddles.resize(aSize / 2);
+    const double kPi = 3.14159265358979323846;
+    for(int k = 0; k < aSize / 2; k++)
+        outPlan.twiddles[k] = Complex((float)cos(2.0 * kPi * k / aSize), (float)-sin(2.0 * kPi * k / aSize));
+}
+
+void RealFft2D::transform(Complex* ioData, const Plan& aPlan, bool isInverse)
+{
+    const int size = aPlan.size;
+    for(int i = 0; i < size; i++)
+    {
+        if(i < aPlan.bitReverse[i])
+            std::swap(ioData[i], ioData[aPlan.bitReverse[i]]);
+    }
+    for(int span = 2; span <= size; span *= 2)
+    {
+        const int half = span / 2, stride = size / span;
+        for(int start = 0; start < size; start += span)
+        {
+            for(int k = 0; k < half; k++)
+            {
+                const Complex& twiddle = aPlan.twiddles[k * stride];
+                const Complex odd = multiply(ioData[start + k + half], isInverse ? std::conj(twiddle) : twiddle);
+                const Complex even = ioData[start + k];
+                ioData[start + k] = even + odd;
+                ioData[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+void RealFft2D::forward(const float* someValues, Complex* outSpectrum) const
+{
+    const int width = myWidth, height = myHeight, spectrumWidth = getSpectrumWidth();
+    // Rows a and b as one complex row a + ib, then pulled apart through the symmetry of real transforms
+    runStrips(height / 2, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        std::vector<Complex> row(width);
+        for(int pair = aBegin; pair < anEnd; pair++)
+        {
+            const float* a = someValues + (size_t)2 * pair * width;
+            const float* b = a + width;
+            for(int x = 0; x < width; x++)
+                row[x] = Complex(a[x], b[x]);
+            transform(row.data(), myRowPlan, false);
+            Complex* outA = outSpectrum + (size_t)2 * pair * spectrumWidth;
+            Complex* outB = outA + spectrumWidth;
+            for(int k = 0; k < spectrumWidth; k++)
+            {
+                const Complex z = row[k], mirror = std::conj(row[(width - k) & (width - 1)]);
+                const Complex sum = z + mirror, difference = z - mirror;
+                outA[k] = Complex(0.5f * sum.real(), 0.5f * sum.imag());
+                // (z - mirror) / 2i
+                outB[k] = Complex(0.5f * difference.imag(), -0.5f * difference.real());
+            }
+        }
+    });
+    runStrips(spectrumWidth, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        std::vector<Complex> column(height);
+        for(int x = aBegin; x < anEnd; x++)
+        {
+            for(int y = 0; y < height; y++)
+                column[y] = outSpectrum[(size_t)y * spectrumWidth + x];
+            transform(column.data(), myColumnPlan, false);
+            for(int y = 0; y < height; y++)
+                outSpectrum[(size_t)y * spectrumWidth + x] = column[y];
+        }
+    });
+}
+
+void RealFft2D::inverse(Complex* ioSpectrum, float* outValues) const
+{
+    const int width = myWidth, height = myHeight, spectrumWidth = getSpectrumWidth();
+    const float scale = 1.f / ((float)width * height);
+    runStrips(spectrumWidth, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        std::vector<Complex> column(height);
+        for(int x = aBegin; x < anEnd; x++)
+        {
+            for(int y = 0; y < height; y++)
+                column[y] = ioSpectrum[(size_t)y * spectrumWidth + x];
+            transform(column.data(), myColumnPlan, true);
+            for(int y = 0; y < height; y++)
+                ioSpectrum[(size_t)y * spectrumWidth + x] = column[y];
+        }
+    });
+    // Two half spectra of real rows rebuilt into one full complex row A + iB, its inverse holds a and b
+    runStrips(height / 2, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        std::vector<Complex> row(width);
+        for(int pair = aBegin; pair < anEnd; pair++)
+        {
+            const Complex* a = ioSpectrum + (size_t)2 * pair * spectrumWidth;
+            const Complex* b = a + spectrumWidth;
+            for(int k = 0; k < width; k++)
+            {
+                const bool isMirrored = k >= spectrumWidth;
+                const Complex binA = isMirrored ? std::conj(a[width - k]) : a[k];
+                const Complex binB = isMirrored ? std::conj(b[width - k]) : b[k];
+                row[k] = Complex(binA.real() - binB.imag(), binA.imag() + binB.real());
+            }
+            transform(row.data(), myRowPlan, true);
+            float* outA = outValues + (size_t)2 * pair * width;
+            float* outB = outA + width;
+            for(int x = 0; x < width; x++)
+            {
+                outA[x] = row[x].real() * scale;
+                outB[x] = row[x].imag() * scale;
+            }
+        }
+    });
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <complex>
+#include <vector>
+
+/// <summary>
+/// Real to complex 2D FFT of a power of two sized board, planned once: bit reversal and twiddle tables
+/// are built in the constructor and reused by every transform. Rows go through in pairs, one as the real
+/// and one as the imaginary part of a single complex FFT, then every column of the half spectrum.
+/// Both passes split their rows or columns over threads.
+/// </summary>
+class RealFft2D
+{
+public:
+    RealFft2D(int aWidth, int aHeight, unsigned aNumThreads);
+
+    int getWidth() const { return myWidth; }
+    int getHeight() const { return myHeight; }
+    /// <summary>
+    /// Bins per row of the half spectrum, the other half mirrors it
+    /// </summary>
+    int getSpectrumWidth() const { return myWidth / 2 + 1; }
+    size_t getSpectrumSize() const { return (size_t)getSpectrumWidth() * myHeight; }
+
+    /// <summary>
+    /// Spectrum of width * height values stored row after row
+    /// </summary>
+    /// <param name="outSpectrum">getSpectrumSize() bins, row after row</param>
+    void forward(const float* someValues, std::complex<float>* outSpectrum) const;
+    /// <summary>
+    /// Values back from a half spectrum, scaled so forward then inverse returns the input
+    /// </summary>
+    /// <param name="ioSpectrum">Used as scratch, left undefined</param>
+    void inverse(std::complex<float>* ioSpectrum, float* outValues) const;
+
+private:
+    struct Plan
+    {
+        int size;
+        std::vector<int> bitReverse;
+        // exp(-2 pi i k / size) for k below size / 2
+        std::vector<std::complex<float>> twiddles;
+    };
+
+    static void makePlan(int aSize, Plan& outPlan);
+    static void transform(std::complex<float>* ioData, const Plan& aPlan, bool isInverse);
+
+    int myWidth, myHeight;
+    unsigned myNumThreads;
+    Plan myRowPlan, myColumnPlan;
+};
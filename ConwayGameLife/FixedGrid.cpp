@@ -0,0 +1,81 @@
+#include "FixedGrid.h"
+#include "BitOps.h"
+#include "Changes.h"
+#include "LifeEngine.h"
+#include "LifeStats.h"
+
+template class Grid<60, 60>;
+template class Grid<64, 64>;
+template class Grid<256, 256>;
+template class Grid<1024, 1024>;
+
+/// <summary>
+/// A Grid behind the engine face, reported as dense bits since it is the same board layout
+/// </summary>
+template<int N>
+class FixedBitsEngine : public LifeEngine
+{
+public:
+    // The biggest grid is too large for the stack
+    FixedBitsEngine() : myGrid(new Grid<N, N>()), myHasHistory(false) {}
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return N; }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        myGrid->clear();
+        for(auto& cell : someCells)
+            myGrid->set(cell.x, cell.y, true);
+        myHasHistory = false;
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        saveWords(myGrid->getRow(0), Grid<N, N>::kWordsPerRow, N, outCells);
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+            myGrid->step();
+        myHasHistory |= aGenerations > 0;
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        sampleWords(myGrid->getRow(0), Grid<N, N>::kWordsPerRow, N, outStats);
+    }
+
+    bool getChanges(ChangeList& outChanges) const override
+    {
+        if(!myHasHistory)
+        {
+            outChanges.clear();
+            return false;
+        }
+        collectChanges(myGrid->getRow(0), myGrid->getPreviousRow(0), Grid<N, N>::kWordsPerRow, N, outChanges);
+        return true;
+    }
+
+private:
+    std::unique_ptr<Grid<N, N>> myGrid;
+    bool myHasHistory;
+};
+
+std::unique_ptr<LifeEngine> createFixedEngine(int aSide)
+{
+    switch(aSide)
+    {
+    case 60:
+        return std::unique_ptr<LifeEngine>(new FixedBitsEngine<60>());
+    case 64:
+        return std::unique_ptr<LifeEngine>(new FixedBitsEngine<64>());
+    case 256:
+        return std::unique_ptr<LifeEngine>(new FixedBitsEngine<256>());
+    case 1024:
+        return std::unique_ptr<LifeEngine>(new FixedBitsEngine<1024>());
+    default:
+        return nullptr;
+    }
+}
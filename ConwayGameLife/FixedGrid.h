@@ -0,0 +1,117 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "BitGrid.h"
+
+class LifeEngine;
+
+/// <summary>
+/// Dense torus of a size fixed at compile time, laid out like BitGrid. Row words are a constant, so the word
+/// loop unrolls into straight code and the wrap across the left and right edges is resolved per word at compile time.
+/// The first and last rows are peeled off, the rows in between never wrap.
+/// </summary>
+template<int W, int H>
+class Grid
+{
+public:
+    static_assert(W >= 1 && H >= 2, "the peeled step needs two rows");
+    static constexpr int kWordsPerRow = (W + 63) / 64;
+    static constexpr uint64_t kTailMask = W % 64 ? (1ULL << (W % 64)) - 1 : ~0ULL;
+
+    Grid() { clear(); }
+
+    void clear()
+    {
+        myCells.fill(0);
+    }
+
+    bool get(int x, int y) const
+    {
+        return (myCells[y * kWordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    void set(int x, int y, bool isLive)
+    {
+        uint64_t& word = myCells[y * kWordsPerRow + (x >> 6)];
+        const uint64_t bit = 1ULL << (x & 63);
+        word = isLive ? word | bit : word & ~bit;
+    }
+
+    const uint64_t* getRow(int y) const { return &myCells[y * kWordsPerRow]; }
+    /// <summary>
+    /// Row of the generation before the last step
+    /// </summary>
+    const uint64_t* getPreviousRow(int y) const { return &myNextCells[y * kWordsPerRow]; }
+
+    /// <summary>
+    /// Advance one generation of B3/S23
+    /// </summary>
+    void step()
+    {
+        const uint64_t* cells = myCells.data();
+        uint64_t* next = myNextCells.data();
+        const auto words = std::make_index_sequence<kWordsPerRow>();
+        stepRow(cells + (H - 1) * kWordsPerRow, cells, cells + kWordsPerRow, next, words);
+        for(int y = 1; y + 1 < H; y++)
+            stepRow(cells + (y - 1) * kWordsPerRow, cells + y * kWordsPerRow, cells + (y + 1) * kWordsPerRow, next + y * kWordsPerRow, words);
+        stepRow(cells + (H - 2) * kWordsPerRow, cells + (H - 1) * kWordsPerRow, cells, next + (H - 1) * kWordsPerRow, words);
+        myCells.swap(myNextCells);
+    }
+
+private:
+    /// <summary>
+    /// Row shifted so that bit x holds cell x - 1
+    /// </summary>
+    template<int I>
+    static uint64_t westOf(const uint64_t* aRow)
+    {
+        if constexpr(I > 0)
+            return aRow[I] << 1 | aRow[I - 1] >> 63;
+        else
+            return aRow[0] << 1 | (aRow[(W - 1) >> 6] >> ((W - 1) & 63) & 1);
+    }
+
+    /// <summary>
+    /// Row shifted so that bit x holds cell x + 1
+    /// </summary>
+    template<int I>
+    static uint64_t eastOf(const uint64_t* aRow)
+    {
+        if constexpr(I + 1 < kWordsPerRow)
+            return aRow[I] >> 1 | aRow[I + 1] << 63;
+        else
+            return aRow[I] >> 1 | (aRow[0] & 1) << ((W - 1) & 63);
+    }
+
+    template<int I>
+    static uint64_t nextWord(const uint64_t* anAbove, const uint64_t* aCenter, const uint64_t* aBelow)
+    {
+        const uint64_t word = lifeWord(westOf<I>(anAbove), anAbove[I], eastOf<I>(anAbove),
+                                       westOf<I>(aCenter), aCenter[I], eastOf<I>(aCenter),
+                                       westOf<I>(aBelow), aBelow[I], eastOf<I>(aBelow));
+        return I + 1 == kWordsPerRow ? word & kTailMask : word;
+    }
+
+    template<size_t... Indices>
+    static void stepRow(const uint64_t* anAbove, const uint64_t* aCenter, const uint64_t* aBelow, uint64_t* outRow,
+                        std::index_sequence<Indices...>)
+    {
+        ((outRow[Indices] = nextWord<(int)Indices>(anAbove, aCenter, aBelow)), ...);
+    }
+
+    std::array<uint64_t, (size_t)H * kWordsPerRow> myCells;
+    std::array<uint64_t, (size_t)H * kWordsPerRow> myNextCells;
+};
+
+// Compiled once in FixedGrid.cpp, the shipped board and the common powers of two
+extern template class Grid<60, 60>;
+extern template class Grid<64, 64>;
+extern template class Grid<256, 256>;
+extern template class Grid<1024, 1024>;
+
+/// <summary>
+/// Engine over the compiled in Grid of this side, nullptr when there is none
+/// </summary>
+std::unique_ptr<LifeEngine> createFixedEngine(int aSide);
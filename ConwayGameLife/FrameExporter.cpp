@@ -0,0 +1,342 @@
+#include "FrameExporter.h"
+#include <algorithm>
+#include "Log.h"
+#include "PngWriter.h"
+#include "PopulationPyramid.h"
+
+// GIF frame delay in hundredths of a second
+static const int kGifDelay = 4;
+// Colours of the GIF palette, a grey ramp indexed by the top bits of a shade
+static const int kGifColorBits = 4;
+static const int kMaxLzwCodes = 4096;
+// Least time between two warnings about dropped frames
+static const std::chrono::seconds kDropReportPeriod(5);
+
+/// <summary>
+/// Codes of growing width packed from the low bit up, as GIF's LZW wants them
+/// </summary>
+class CodeWriter
+{
+public:
+    explicit CodeWriter(std::vector<uint8_t>& outBytes)
+        : myBytes(outBytes)
+        , myBits(0)
+        , myNumBits(0)
+    {
+    }
+
+    void write(int aCode, int aCodeSize)
+    {
+        myBits |= (uint32_t)aCode << myNumBits;
+        myNumBits += aCodeSize;
+        while(myNumBits >= 8)
+        {
+            myBytes.push_back((uint8_t)myBits);
+            myBits >>= 8;
+            myNumBits -= 8;
+        }
+    }
+
+    void flush()
+    {
+        if(myNumBits > 0)
+            myBytes.push_back((uint8_t)myBits);
+        myBits = 0;
+        myNumBits = 0;
+    }
+
+private:
+    std::vector<uint8_t>& myBytes;
+    uint32_t myBits;
+    int myNumBits;
+};
+
+static void writeShort(std::vector<uint8_t>& outBytes, int aValue)
+{
+    outBytes.push_back((uint8_t)(aValue & 0xFF));
+    outBytes.push_back((uint8_t)(aValue >> 8));
+}
+
+/// <summary>
+/// Screen descriptor, the grey palette and the extension that loops the animation
+/// </summary>
+static void writeGifHeader(int aSide, std::vector<uint8_t>& outBytes)
+{
+    const char kSignature[] = "GIF89a";
+    outBytes.insert(outBytes.end(), kSignature, kSignature + 6);
+    writeShort(outBytes, aSide);
+    writeShort(outBytes, aSide);
+    // Global colour table of 2^kGifColorBits entries, 8 bits of colour resolution
+    outBytes.push_back((uint8_t)(0x80 | 0x70 | (kGifColorBits - 1)));
+    outBytes.push_back(0);
+    outBytes.push_back(0);
+    for(int i = 0; i < (1 << kGifColorBits); i++)
+    {
+        const uint8_t grey = (uint8_t)(i * 255 / ((1 << kGifColorBits) - 1));
+        outBytes.insert(outBytes.end(), { grey, grey, grey });
+    }
+    const char kLoop[] = "\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00";
+    outBytes.insert(outBytes.end(), kLoop, kLoop + sizeof(kLoop) - 1);
+}
+
+/// <summary>
+/// One GIF frame, its delay, descriptor and LZW compressed palette indices in blocks of up to 255 bytes
+/// </summary>
+static void encodeGifFrame(const uint8_t* someShades, int aSide, std::vector<uint8_t>& outBytes)
+{
+    outBytes.clear();
+    const uint8_t kControl[] = { 0x21, 0xF9, 0x04, 0x00, (uint8_t)(kGifDelay & 0xFF), (uint8_t)(kGifDelay >> 8), 0x00, 0x00 };
+    outBytes.insert(outBytes.end(), kControl, kControl + sizeof(kControl));
+    outBytes.push_back(0x2C);
+    writeShort(outBytes, 0);
+    writeShort(outBytes, 0);
+    writeShort(outBytes, aSide);
+    writeShort(outBytes, aSide);
+    outBytes.push_back(0);
+    outBytes.push_back((uint8_t)kGifColorBits);
+
+    const int numColors = 1 << kGifColorBits, clearCode = numColors, endCode = numColors + 1;
+    const int shift = 8 - kGifColorBits;
+    // Code of each string extended by each colour, 0 where there is none yet as no string gets code 0
+    std::vector<uint16_t> children((size_t)kMaxLzwCodes * numColors, 0);
+    std::vector<uint8_t> data;
+    CodeWriter writer(data);
+    int codeSize = kGifColorBits + 1, nextCode = endCode + 1;
+    writer.write(clearCode, codeSize);
+    const size_t numPixels = (size_t)aSide * aSide;
+    int current = someShades[0] >> shift;
+    for(size_t i = 1; i < numPixels; i++)
+    {
+        const int color = someShades[i] >> shift;
+        const int child = children[(size_t)current * numColors + color];
+        if(child)
+        {
+            current = child;
+            continue;
+        }
+        writer.write(current, codeSize);
+        children[(size_t)current * numColors + color] = (uint16_t)nextCode;
+        // The decoder adds this code one step later, both widen once it no longer fits
+        if(nextCode >= (1 << codeSize))
+            codeSize++;
+        if(++nextCode == kMaxLzwCodes)
+        {
+            writer.write(clearCode, codeSize);
+            std::fill(children.begin(), children.end(), 0);
+            codeSize = kGifColorBits + 1;
+            nextCode = endCode + 1;
+        }
+        current = color;
+    }
+    writer.write(current, codeSize);
+    // Reading the last code gives the decoder one more entry, which can widen its codes before the end code
+    if(nextCode >= (1 << codeSize) && codeSize < 12)
+        codeSize++;
+    writer.write(endCode, codeSize);
+    writer.flush();
+    for(size_t begin = 0; begin < data.size(); begin += 255)
+    {
+        const size_t size = std::min<size_t>(255, data.size() - begin);
+        outBytes.push_back((uint8_t)size);
+        outBytes.insert(outBytes.end(), data.begin() + begin, data.begin() + begin + size);
+    }
+    outBytes.push_back(0);
+}
+
+FrameExporter::~FrameExporter()
+{
+    close();
+}
+
+bool FrameExporter::open(const std::string& aPath, int aHalfSide, unsigned aNumThreads, int aQueueLength, bool isWaitingWhenFull)
+{
+    close();
+    const bool isGif = aPath.size() > 4 && ".gif" == aPath.substr(aPath.size() - 4);
+    myFormat = isGif ? ExportFormat::AnimatedGif : ExportFormat::PngSequence;
+    myPath = aPath;
+    myHalfSide = aHalfSide;
+    // The pyramid halves the side, rounding up, at every level
+    myLevel = 0;
+    myFrameSide = 2 * aHalfSide;
+    while(myFrameSide > kMaxFrameSide)
+    {
+        myFrameSide = (myFrameSide + 1) / 2;
+        myLevel++;
+    }
+    myIsWaitingWhenFull = isWaitingWhenFull;
+    if(isGif)
+    {
+        myGifFile = fopen(aPath.c_str(), "wb");
+        if(nullptr == myGifFile)
+            return false;
+        std::vector<uint8_t> header;
+        writeGifHeader(myFrameSide, header);
+        fwrite(header.data(), 1, header.size(), myGifFile);
+    }
+    myIsStopping = false;
+    myNumAccepted = myNumDropped = 0;
+    myNextWritten = myNumWritten = myNumFailed = myNumBytes = 0;
+    // The first drop is reported straight away
+    myLastDropReport = std::chrono::steady_clock::now() - kDropReportPeriod;
+    myFreeFrames.clear();
+    for(int i = 0; i < std::max(1, aQueueLength); i++)
+    {
+        myFreeFrames.emplace_back(new Frame());
+        myFreeFrames.back()->shades.resize((size_t)myFrameSide * myFrameSide);
+    }
+    for(unsigned i = 0; i < std::max(1u, aNumThreads); i++)
+        myThreads.emplace_back(&FrameExporter::encodeLoop, this);
+    LOG_INFO("exporting %dx%d frames to %s, %d buffers, %u encoders\n", myFrameSide, myFrameSide, aPath.c_str(),
+             (int)myFreeFrames.size(), (unsigned)myThreads.size());
+    return true;
+}
+
+void FrameExporter::close()
+{
+    if(!isOpen())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(myQueueMutex);
+        myIsStopping = true;
+    }
+    myQueueCondition.notify_all();
+    for(auto& thread : myThreads)
+        thread.join();
+    myThreads.clear();
+    myFreeFrames.clear();
+    if(nullptr != myGifFile)
+    {
+        fputc(0x3B, myGifFile);
+        fclose(myGifFile);
+        myGifFile = nullptr;
+    }
+    if(myNumFailed)
+        LOG_ERROR("%llu frames could not be written to %s\n", (unsigned long long)myNumFailed, myPath.c_str());
+    LOG_INFO("exported %llu frames, %llu bytes, %llu dropped\n", (unsigned long long)myNumWritten, (unsigned long long)myNumBytes,
+             (unsigned long long)myNumDropped);
+}
+
+uint64_t FrameExporter::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(myQueueMutex);
+    return myNumDropped;
+}
+
+bool FrameExporter::submit(uint64_t aGeneration, const TileSet& someTiles, const PopulationPyramid& aPyramid)
+{
+    std::unique_ptr<Frame> frame;
+    {
+        std::unique_lock<std::mutex> lock(myQueueMutex);
+        if(myIsWaitingWhenFull)
+            myFreeCondition.wait(lock, [this]() { return !myFreeFrames.empty(); });
+        if(myFreeFrames.empty())
+        {
+            myNumDropped++;
+            const auto now = std::chrono::steady_clock::now();
+            if(now - myLastDropReport >= kDropReportPeriod)
+            {
+                LOG_WARNING("export queue full, %llu frames dropped so far\n", (unsigned long long)myNumDropped);
+                myLastDropReport = now;
+            }
+            return false;
+        }
+        frame = std::move(myFreeFrames.back());
+        myFreeFrames.pop_back();
+        frame->sequence = myNumAccepted++;
+    }
+    // Shaded outside the lock, the encoders only ever see finished frames
+    frame->generation = aGeneration;
+    render(someTiles, aPyramid, frame->shades);
+    {
+        std::lock_guard<std::mutex> lock(myQueueMutex);
+        myQueue.push_back(std::move(frame));
+    }
+    myQueueCondition.notify_one();
+    return true;
+}
+
+void FrameExporter::render(const TileSet& someTiles, const PopulationPyramid& aPyramid, std::vector<uint8_t>& outShades) const
+{
+    const int side = myFrameSide;
+    if(0 == myLevel)
+    {
+        std::fill(outShades.begin(), outShades.end(), 0);
+        for(auto& tile : someTiles)
+            outShades[(size_t)(tile.y + myHalfSide) * side + tile.x + myHalfSide] = 255;
+        return;
+    }
+    // Shaded like the zoomed out view, any life at all stays visible
+    const uint32_t* counts = aPyramid.getLevel(myLevel);
+    const float tilesPerBlock = (float)(1 << myLevel) * (1 << myLevel);
+    for(size_t i = 0; i < outShades.size(); i++)
+        outShades[i] = counts[i] ? (uint8_t)(64 + 191 * std::min(1.f, counts[i] / tilesPerBlock)) : 0;
+}
+
+void FrameExporter::encodeLoop()
+{
+    std::vector<uint8_t> bytes;
+    char name[32];
+    while(true)
+    {
+        std::unique_ptr<Frame> frame;
+        {
+            std::unique_lock<std::mutex> lock(myQueueMutex);
+            myQueueCondition.wait(lock, [this]() { return myIsStopping || !myQueue.empty(); });
+            // Stopping still drains what was queued
+            if(myQueue.empty())
+                return;
+            frame = std::move(myQueue.front());
+            myQueue.pop_front();
+        }
+        if(ExportFormat::AnimatedGif == myFormat)
+            encodeGifFrame(frame->shades.data(), myFrameSide, bytes);
+        else
+        {
+            bytes.clear();
+            encodePng(frame->shades.data(), myFrameSide, myFrameSide, 1, bytes);
+        }
+        const uint64_t generation = frame->generation, sequence = frame->sequence;
+        {
+            std::lock_guard<std::mutex> lock(myQueueMutex);
+            myFreeFrames.push_back(std::move(frame));
+        }
+        myFreeCondition.notify_one();
+
+        if(ExportFormat::PngSequence == myFormat)
+        {
+            // Numbered by generation, each its own file so any order will do
+            snprintf(name, sizeof(name), "%08llu.png", (unsigned long long)generation);
+            FILE* file = fopen((myPath + name).c_str(), "wb");
+            bool isWritten = nullptr != file && bytes.size() == fwrite(bytes.data(), 1, bytes.size(), file);
+            if(nullptr != file)
+                isWritten = 0 == fclose(file) && isWritten;
+            std::lock_guard<std::mutex> lock(myWriteMutex);
+            if(isWritten)
+            {
+                myNumWritten++;
+                myNumBytes += bytes.size();
+            }
+            else
+            {
+                myNumFailed++;
+            }
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(myWriteMutex);
+        myEncodedFrames[sequence].swap(bytes);
+        for(auto next = myEncodedFrames.find(myNextWritten); myEncodedFrames.end() != next; next = myEncodedFrames.find(myNextWritten))
+        {
+            if(next->second.size() == fwrite(next->second.data(), 1, next->second.size(), myGifFile))
+            {
+                myNumWritten++;
+                myNumBytes += next->second.size();
+            }
+            else
+            {
+                myNumFailed++;
+            }
+            myEncodedFrames.erase(next);
+            myNextWritten++;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TileSet.h"
+
+class PopulationPyramid;
+
+enum ExportFormat
+{
+    PngSequence, // One numbered PNG a frame
+    AnimatedGif // Every frame in one looping GIF
+};
+
+/// <summary>
+/// Records the world as pictures while it runs. Frames are shaded straight from the live tiles, or from the
+/// population pyramid once the world is wider than kMaxFrameSide, into a pool of reused buffers, then encoded
+/// and written on worker threads. The caller only waits when every buffer is in flight and it asked to,
+/// otherwise that frame is dropped and counted.
+/// </summary>
+class FrameExporter
+{
+public:
+    // Frames wider than this shade pyramid blocks instead of cells
+    static const int kMaxFrameSide = 1024;
+
+    FrameExporter() = default;
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+    ~FrameExporter();
+
+    /// <param name="aPath">A path ending in .gif writes one animated GIF, anything else is the prefix of numbered PNG files</param>
+    /// <param name="aHalfSide">Half length of the torus, tiles range from -aHalfSide to aHalfSide - 1</param>
+    /// <param name="aQueueLength">Frames waiting or being encoded at most</param>
+    /// <param name="isWaitingWhenFull">Hold submit until a buffer frees up instead of dropping the frame</param>
+    bool open(const std::string& aPath, int aHalfSide, unsigned aNumThreads, int aQueueLength, bool isWaitingWhenFull);
+    /// <summary>
+    /// Encode and write every frame still queued, then log what was written and dropped
+    /// </summary>
+    void close();
+    bool isOpen() const { return !myThreads.empty(); }
+
+    /// <summary>
+    /// Shade the world into a free buffer and queue it for the encoders
+    /// </summary>
+    /// <param name="aPyramid">Read instead of the tiles for worlds wider than kMaxFrameSide</param>
+    /// <returns>False when the frame was dropped</returns>
+    bool submit(uint64_t aGeneration, const TileSet& someTiles, const PopulationPyramid& aPyramid);
+
+    ExportFormat getFormat() const { return myFormat; }
+    int getFrameSide() const { return myFrameSide; }
+    uint64_t getNumDropped() const;
+
+private:
+    struct Frame
+    {
+        uint64_t generation;
+        // Order frames were accepted in, the GIF is written in this order
+        uint64_t sequence;
+        // One shade a pixel, 0 for empty
+        std::vector<uint8_t> shades;
+    };
+
+    void encodeLoop();
+    void render(const TileSet& someTiles, const PopulationPyramid& aPyramid, std::vector<uint8_t>& outShades) const;
+
+    ExportFormat myFormat = ExportFormat::PngSequence;
+    std::string myPath;
+    int myHalfSide = 0;
+    // Pyramid level frames are shaded from, 0 for single cells, and the frame side it gives
+    int myLevel = 0;
+    int myFrameSide = 0;
+    bool myIsWaitingWhenFull = false;
+
+    mutable std::mutex myQueueMutex;
+    std::condition_variable myQueueCondition, myFreeCondition;
+    std::vector<std::unique_ptr<Frame>> myFreeFrames;
+    std::deque<std::unique_ptr<Frame>> myQueue;
+    bool myIsStopping = false;
+    uint64_t myNumAccepted = 0, myNumDropped = 0;
+    std::chrono::steady_clock::time_point myLastDropReport;
+    std::vector<std::thread> myThreads;
+
+    // GIF frames encoded out of order wait here for the ones before them
+    std::mutex myWriteMutex;
+    FILE* myGifFile = nullptr;
+    std::map<uint64_t, std::vector<uint8_t>> myEncodedFrames;
+    uint64_t myNextWritten = 0;
+    // Frames written whole and frames a write failed on, only the written ones count towards the bytes
+    uint64_t myNumWritten = 0, myNumFailed = 0, myNumBytes = 0;
+};
@@ -0,0 +1,63 @@
+#include "FramePacer.h"
+#include <SFML/System/Sleep.hpp>
+#include <cstdint>
+#include <ctime>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include "Log.h"
+
+/// <summary>
+/// User and kernel time of the whole process, every thread included
+/// </summary>
+static double getProcessCpuSeconds()
+{
+#ifdef _WIN32
+    // clock() is wall time on Windows
+    FILETIME creation, exit, kernel, user;
+    if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    auto toSeconds = [](const FILETIME& aTime)
+    {
+        return (double)(((uint64_t)aTime.dwHighDateTime << 32) | aTime.dwLowDateTime) * 1e-7;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+FramePacer::FramePacer(int aFramesPerSecond)
+    : myPeriod(sf::microseconds(1000000 / aFramesPerSecond))
+    , myNumFrames(0)
+    , myReportCpuSeconds(getProcessCpuSeconds())
+{
+}
+
+void FramePacer::wait()
+{
+    sf::Time now = myClock.getElapsedTime();
+    if(now >= myNextFrame + myPeriod)
+    {
+        myNextFrame = now + myPeriod;
+        return;
+    }
+    if(now < myNextFrame)
+        sf::sleep(myNextFrame - now);
+    myNextFrame += myPeriod;
+}
+
+void FramePacer::report(sf::Time aPeriod)
+{
+    const sf::Time now = myClock.getElapsedTime();
+    if(now - myReportStart < aPeriod)
+        return;
+    const double cpuSeconds = getProcessCpuSeconds();
+    const double seconds = (now - myReportStart).asSeconds();
+    LOG_INFO("%.1f frames/s, cpu %.1f%% of a core\n", myNumFrames / seconds, 100.0 * (cpuSeconds - myReportCpuSeconds) / seconds);
+    myReportStart = now;
+    myReportCpuSeconds = cpuSeconds;
+    myNumFrames = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+
+/// <summary>
+/// Holds the render loop to a steady frame rate by sleeping out the rest of each frame,
+/// and meters the CPU time the process uses so the cost of the loop can be checked
+/// </summary>
+class FramePacer
+{
+public:
+    explicit FramePacer(int aFramesPerSecond);
+
+    /// <summary>
+    /// Sleep until the next frame is due. Deadlines move on by whole periods so the cadence does not drift,
+    /// a loop more than a period late starts over from now instead of rushing frames to catch up.
+    /// </summary>
+    void wait();
+    /// <summary>
+    /// Count a frame drawn, for the report
+    /// </summary>
+    void countFrame() { myNumFrames++; }
+    /// <summary>
+    /// Once every aPeriod, log the frames drawn per second and the CPU used as a share of one core
+    /// </summary>
+    void report(sf::Time aPeriod);
+
+private:
+    sf::Clock myClock;
+    sf::Time myPeriod;
+    sf::Time myNextFrame;
+    int myNumFrames;
+    sf::Time myReportStart;
+    double myReportCpuSeconds;
+};
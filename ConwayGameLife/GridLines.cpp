@@ -0,0 +1,76 @@
+#include "GridLines.h"
+#include <algorithm>
+#include <cmath>
+#include "Log.h"
+
+// Below this many pixels between lines the grid is a solid field, it is left out
+static const float kMinLinePixels = 4.f;
+// Cached lines wider or taller than this many views get rebuilt tighter after zooming in
+static const int kMaxViewsCovered = 4;
+
+GridLines::GridLines(float aSpacing)
+    : mySpacing(aSpacing)
+    , myLeft(0)
+    , myTop(0)
+    , myRight(0)
+    , myBottom(0)
+    , myHalfSide(0)
+    , myBuffer(sf::Lines, sf::VertexBuffer::Static)
+{
+}
+
+void GridLines::draw(sf::RenderTarget& aTarget, const sf::View& aView, int aHalfSide)
+{
+    const sf::Vector2f viewSize = aView.getSize();
+    if(mySpacing * aTarget.getSize().x / viewSize.x < kMinLinePixels)
+        return;
+    const sf::Vector2f viewMin = aView.getCenter() - viewSize / 2.f, viewMax = aView.getCenter() + viewSize / 2.f;
+    const int left = std::max(-aHalfSide, (int)floor(viewMin.x / mySpacing));
+    const int top = std::max(-aHalfSide, (int)floor(viewMin.y / mySpacing));
+    const int right = std::min(aHalfSide, (int)ceil(viewMax.x / mySpacing));
+    const int bottom = std::min(aHalfSide, (int)ceil(viewMax.y / mySpacing));
+    if(right <= left || bottom <= top)
+        return;
+    const int viewCellsX = (int)ceil(viewSize.x / mySpacing) + 1, viewCellsY = (int)ceil(viewSize.y / mySpacing) + 1;
+    const bool isCovered = myLeft <= left && myTop <= top && myRight >= right && myBottom >= bottom;
+    const bool isTooLarge = myRight - myLeft > kMaxViewsCovered * viewCellsX || myBottom - myTop > kMaxViewsCovered * viewCellsY;
+    if(!isCovered || isTooLarge || aHalfSide != myHalfSide)
+    {
+        myHalfSide = aHalfSide;
+        rebuild(std::max(-aHalfSide, left - viewCellsX / 2), std::max(-aHalfSide, top - viewCellsY / 2),
+                std::min(aHalfSide, right + viewCellsX / 2), std::min(aHalfSide, bottom + viewCellsY / 2));
+    }
+    if(!sf::VertexBuffer::isAvailable())
+    {
+        aTarget.draw(myVertices.data(), myVertices.size(), sf::Lines);
+        return;
+    }
+    aTarget.draw(myBuffer, 0, myVertices.size());
+}
+
+void GridLines::rebuild(int aLeft, int aTop, int aRight, int aBottom)
+{
+    myLeft = aLeft;
+    myTop = aTop;
+    myRight = aRight;
+    myBottom = aBottom;
+    const float left = aLeft * mySpacing, top = aTop * mySpacing, right = aRight * mySpacing, bottom = aBottom * mySpacing;
+    myVertices.clear();
+    myVertices.reserve(2 * (aBottom - aTop + 1 + aRight - aLeft + 1));
+    for(int y = aTop; y <= aBottom; y++)
+    {
+        myVertices.push_back(sf::Vertex(sf::Vector2f(left, y * mySpacing)));
+        myVertices.push_back(sf::Vertex(sf::Vector2f(right, y * mySpacing)));
+    }
+    for(int x = aLeft; x <= aRight; x++)
+    {
+        myVertices.push_back(sf::Vertex(sf::Vector2f(x * mySpacing, top)));
+        myVertices.push_back(sf::Vertex(sf::Vector2f(x * mySpacing, bottom)));
+    }
+    LOG_DEBUG("grid lines rebuilt over %dx%d cells, %d vertices\n", aRight - aLeft, aBottom - aTop, (int)myVertices.size());
+    if(!sf::VertexBuffer::isAvailable())
+        return;
+    if(myBuffer.getVertexCount() < myVertices.size() && !myBuffer.create(myVertices.size()))
+        return;
+    myBuffer.update(myVertices.data(), myVertices.size(), 0);
+}
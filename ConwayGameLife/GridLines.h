@@ -0,0 +1,29 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+/// <summary>
+/// Grid lines kept on the GPU between frames. They cover the cells in view plus half a view on every side,
+/// so panning and zooming only rebuild them once the view leaves that area or shrinks well inside it.
+/// Hidden once cells get too small on screen for the lines to be told apart.
+/// </summary>
+class GridLines
+{
+public:
+    explicit GridLines(float aSpacing);
+
+    /// <summary>
+    /// Draw the lines of the world cells under aView, rebuilding them first if the view moved off them
+    /// </summary>
+    void draw(sf::RenderTarget& aTarget, const sf::View& aView, int aHalfSide);
+
+private:
+    void rebuild(int aLeft, int aTop, int aRight, int aBottom);
+
+    float mySpacing;
+    // Cells the lines cover, right and bottom exclusive
+    int myLeft, myTop, myRight, myBottom;
+    int myHalfSide;
+    std::vector<sf::Vertex> myVertices;
+    sf::VertexBuffer myBuffer;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include "Log.h"
+
+// Generations a step is checked against its naive reference over, the naive ones are slow
+static const int kCheckGenerations = 5;
+// Population reports per timed run
+static const int kNumReports = 10;
+
+inline double secondsSince(const std::chrono::steady_clock::time_point& aStart)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+/// <summary>
+/// Call aStep aNumCalls times
+/// </summary>
+/// <returns>Seconds a call took on average</returns>
+template<typename F>
+static double timePerCall(int aNumCalls, F aStep)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < aNumCalls; i++)
+        aStep();
+    return secondsSince(start) / aNumCalls;
+}
+
+/// <summary>
+/// Step a grid aGenerations times, logging its population kNumReports times on the way and the speed at the end
+/// </summary>
+/// <returns>Seconds the steps took, the reports left out</returns>
+template<typename G>
+static double runWithReports(G& ioGrid, int aGenerations, double aNumCells)
+{
+    const int reportEvery = std::max(1, aGenerations / kNumReports);
+    double seconds = 0.0;
+    for(int generation = 1; generation <= aGenerations; generation++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ioGrid.step();
+        seconds += secondsSince(start);
+        if(0 == generation % reportEvery)
+            LOG_INFO("generation %d, population %llu\n", generation, (unsigned long long)ioGrid.getPopulation());
+    }
+    LOG_INFO("%d generations in %.3f s, %.3f ms/gen, %.4g cells/s\n", aGenerations, seconds, seconds * 1e3 / aGenerations,
+             aNumCells * aGenerations / seconds);
+    return seconds;
+}
+
+/// <summary>
+/// Run two grids loaded with the same board aGenerations each, one through step and the other through stepNaive
+/// </summary>
+/// <param name="outSeconds">Seconds a generation of step took</param>
+/// <param name="outNaiveSeconds">Seconds a generation of stepNaive took</param>
+/// <returns>If the two end on the same cells</returns>
+template<typename G>
+static bool checkAgainstNaive(G& ioGrid, G& ioNaive, int aGenerations, double& outSeconds, double& outNaiveSeconds)
+{
+    outSeconds = timePerCall(aGenerations, [&ioGrid]() { ioGrid.step(); });
+    outNaiveSeconds = timePerCall(aGenerations, [&ioNaive]() { ioNaive.stepNaive(); });
+    return ioGrid.getCells() == ioNaive.getCells();
+}
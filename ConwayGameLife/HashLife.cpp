@@ -0,0 +1,245 @@
+#include "HashLife.h"
+#include <algorithm>
+#include "BitOps.h"
+#include "LifeStats.h"
+
+// Past this the cache is dropped and rebuilt from the live cells
+static const size_t kMaxNodes = 1 << 21;
+
+size_t HashLife::NodeKeyHash::operator()(const NodeKey& aKey) const
+{
+    uint64_t result = mix64((uint64_t)(uintptr_t)aKey.nw);
+    result = mix64(result ^ (uint64_t)(uintptr_t)aKey.ne);
+    result = mix64(result ^ (uint64_t)(uintptr_t)aKey.sw);
+    return (size_t)mix64(result ^ (uint64_t)(uintptr_t)aKey.se);
+}
+
+HashLife::HashLife(int aLevel)
+    : myLevel(aLevel)
+{
+    myDead = { nullptr, nullptr, nullptr, nullptr, 0, 0, 0, nullptr };
+    myAlive = { nullptr, nullptr, nullptr, nullptr, 1, 0, 0, nullptr };
+    reset();
+}
+
+void HashLife::reset()
+{
+    myNodes.clear();
+    myStorage.clear();
+    myEmptyNodes.assign(1, &myDead);
+    myRoot = getEmpty(myLevel);
+}
+
+HashLife::Node* HashLife::join(Node* aNW, Node* aNE, Node* aSW, Node* aSE)
+{
+    NodeKey key = { aNW, aNE, aSW, aSE };
+    auto it = myNodes.find(key);
+    if(myNodes.end() != it)
+        return it->second;
+    myStorage.push_back({ aNW, aNE, aSW, aSE,
+                          aNW->population + aNE->population + aSW->population + aSE->population,
+                          aNW->level + 1, -1, nullptr });
+    Node* node = &myStorage.back();
+    myNodes.emplace(key, node);
+    return node;
+}
+
+HashLife::Node* HashLife::getEmpty(int aLevel)
+{
+    while((int)myEmptyNodes.size() <= aLevel)
+    {
+        Node* child = myEmptyNodes.back();
+        myEmptyNodes.push_back(join(child, child, child, child));
+    }
+    return myEmptyNodes[aLevel];
+}
+
+/// <summary>
+/// Centre quarter of a node, one level down
+/// </summary>
+HashLife::Node* HashLife::getCentre(Node* aNode)
+{
+    return join(aNode->nw->se, aNode->ne->sw, aNode->sw->ne, aNode->se->nw);
+}
+
+/// <summary>
+/// One generation of the centre 2x2 of a 4x4 node
+/// </summary>
+HashLife::Node* HashLife::advanceBase(Node* aNode)
+{
+    // Rows of 4 bits, bit x is column x
+    unsigned rows[4];
+    Node* quadrants[4] = { aNode->nw, aNode->ne, aNode->sw, aNode->se };
+    for(int y = 0; y < 4; y++)
+    {
+        Node* left = quadrants[(y >> 1) * 2];
+        Node* right = quadrants[(y >> 1) * 2 + 1];
+        Node* leftPair[2] = { (y & 1) ? left->sw : left->nw, (y & 1) ? left->se : left->ne };
+        Node* rightPair[2] = { (y & 1) ? right->sw : right->nw, (y & 1) ? right->se : right->ne };
+        rows[y] = (unsigned)(leftPair[0]->population | leftPair[1]->population << 1
+                             | rightPair[0]->population << 2 | rightPair[1]->population << 3);
+    }
+    Node* cells[4];
+    for(int i = 0; i < 4; i++)
+    {
+        int x = 1 + (i & 1), y = 1 + (i >> 1);
+        int count = 0;
+        for(int dy = -1; dy <= 1; dy++)
+        {
+            for(int dx = -1; dx <= 1; dx++)
+            {
+                if(dx || dy)
+                    count += (rows[y + dy] >> (x + dx)) & 1;
+            }
+        }
+        bool isLive = 3 == count || (2 == count && ((rows[y] >> x) & 1));
+        cells[i] = isLive ? &myAlive : &myDead;
+    }
+    return join(cells[0], cells[1], cells[2], cells[3]);
+}
+
+/// <summary>
+/// Centre of a node, one level down, advanced by 2^aStep generations, aStep at most level - 2
+/// </summary>
+HashLife::Node* HashLife::advance(Node* aNode, int aStep)
+{
+    if(0 == aNode->population)
+        return getEmpty(aNode->level - 1);
+    if(aNode->result && aNode->resultStep == aStep)
+        return aNode->result;
+    Node* result;
+    if(2 == aNode->level)
+    {
+        result = advanceBase(aNode);
+    }
+    else
+    {
+        Node* nw = aNode->nw;
+        Node* ne = aNode->ne;
+        Node* sw = aNode->sw;
+        Node* se = aNode->se;
+        // The nine overlapping children one level down
+        Node* sub[9] = {
+            nw, join(nw->ne, ne->nw, nw->se, ne->sw), ne,
+            join(nw->sw, nw->se, sw->nw, sw->ne), join(nw->se, ne->sw, sw->ne, se->nw), join(ne->sw, ne->se, se->nw, se->ne),
+            sw, join(sw->ne, se->nw, sw->se, se->sw), se
+        };
+        const bool isFullStep = aStep == aNode->level - 2;
+        Node* part[9];
+        for(int i = 0; i < 9; i++)
+            part[i] = isFullStep ? advance(sub[i], aStep - 1) : getCentre(sub[i]);
+        const int nextStep = isFullStep ? aStep - 1 : aStep;
+        result = join(advance(join(part[0], part[1], part[3], part[4]), nextStep),
+                      advance(join(part[1], part[2], part[4], part[5]), nextStep),
+                      advance(join(part[3], part[4], part[6], part[7]), nextStep),
+                      advance(join(part[4], part[5], part[7], part[8]), nextStep));
+    }
+    aNode->result = result;
+    aNode->resultStep = aStep;
+    return result;
+}
+
+/// <summary>
+/// Advance the torus by 2^aStep generations, aStep at most level - 1
+/// </summary>
+void HashLife::advanceTorus(int aStep)
+{
+    Node* tiled = join(myRoot, myRoot, myRoot, myRoot);
+    Node* shifted = advance(tiled, aStep);
+    myRoot = join(shifted->se, shifted->sw, shifted->ne, shifted->nw);
+}
+
+void HashLife::step(uint64_t aGenerations)
+{
+    const int maxStep = myLevel - 1;
+    while(aGenerations >= (1ULL << maxStep))
+    {
+        advanceTorus(maxStep);
+        aGenerations -= 1ULL << maxStep;
+    }
+    for(int step = maxStep - 1; step >= 0; step--)
+    {
+        if(aGenerations & (1ULL << step))
+            advanceTorus(step);
+    }
+    if(myNodes.size() > kMaxNodes)
+    {
+        std::vector<sf::Vector2i> cells;
+        save(cells);
+        load(cells);
+    }
+}
+
+HashLife::Node* HashLife::build(int aLevel, int x, int y, std::vector<sf::Vector2i>::iterator aBegin, std::vector<sf::Vector2i>::iterator anEnd)
+{
+    if(aBegin == anEnd)
+        return getEmpty(aLevel);
+    if(0 == aLevel)
+        return &myAlive;
+    const int half = 1 << (aLevel - 1);
+    auto bottom = std::partition(aBegin, anEnd, [y, half](const sf::Vector2i& aCell) { return aCell.y < y + half; });
+    auto topRight = std::partition(aBegin, bottom, [x, half](const sf::Vector2i& aCell) { return aCell.x < x + half; });
+    auto bottomRight = std::partition(bottom, anEnd, [x, half](const sf::Vector2i& aCell) { return aCell.x < x + half; });
+    return join(build(aLevel - 1, x, y, aBegin, topRight), build(aLevel - 1, x + half, y, topRight, bottom),
+                build(aLevel - 1, x, y + half, bottom, bottomRight), build(aLevel - 1, x + half, y + half, bottomRight, anEnd));
+}
+
+void HashLife::load(const std::vector<sf::Vector2i>& someCells)
+{
+    reset();
+    std::vector<sf::Vector2i> cells(someCells);
+    myRoot = build(myLevel, 0, 0, cells.begin(), cells.end());
+}
+
+void HashLife::collect(const Node* aNode, int x, int y, std::vector<sf::Vector2i>& outCells) const
+{
+    if(0 == aNode->population)
+        return;
+    if(0 == aNode->level)
+    {
+        outCells.push_back(sf::Vector2i(x, y));
+        return;
+    }
+    const int half = 1 << (aNode->level - 1);
+    collect(aNode->nw, x, y, outCells);
+    collect(aNode->ne, x + half, y, outCells);
+    collect(aNode->sw, x, y + half, outCells);
+    collect(aNode->se, x + half, y + half, outCells);
+}
+
+void HashLife::save(std::vector<sf::Vector2i>& outCells) const
+{
+    outCells.clear();
+    outCells.reserve((size_t)myRoot->population);
+    collect(myRoot, 0, 0, outCells);
+}
+
+uint64_t HashLife::getPopulation() const
+{
+    return myRoot->population;
+}
+
+void HashLife::collectBounds(const Node* aNode, int x, int y, GenerationStats& outStats) const
+{
+    if(0 == aNode->population)
+        return;
+    const int side = 1 << aNode->level;
+    // Nothing to learn from a node already inside the box
+    if(outStats.minX <= x && outStats.minY <= y && x + side - 1 <= outStats.maxX && y + side - 1 <= outStats.maxY)
+        return;
+    if(0 == aNode->level)
+    {
+        outStats.include(x, y);
+        return;
+    }
+    const int half = side / 2;
+    collectBounds(aNode->nw, x, y, outStats);
+    collectBounds(aNode->ne, x + half, y, outStats);
+    collectBounds(aNode->sw, x, y + half, outStats);
+    collectBounds(aNode->se, x + half, y + half, outStats);
+}
+
+void HashLife::getBoundingBox(GenerationStats& outStats) const
+{
+    collectBounds(myRoot, 0, 0, outStats);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+struct GenerationStats;
+
+/// <summary>
+/// Quadtree memoised (Gosper's HashLife) B3/S23 on a torus of side 2^level.
+/// The torus is tiled 2x2 into a node one level up, whose memoised centre result is the torus
+/// shifted by half a side, so a single advance covers up to side / 2 generations.
+/// </summary>
+class HashLife
+{
+public:
+    explicit HashLife(int aLevel);
+    HashLife(const HashLife&) = delete;
+    HashLife& operator=(const HashLife&) = delete;
+
+    int getSide() const { return 1 << myLevel; }
+
+    /// <summary>
+    /// Replace the board, cells from (0, 0) to (side - 1, side - 1)
+    /// </summary>
+    void load(const std::vector<sf::Vector2i>& someCells);
+    void save(std::vector<sf::Vector2i>& outCells) const;
+
+    void step(uint64_t aGenerations);
+
+    uint64_t getPopulation() const;
+    void getBoundingBox(GenerationStats& outStats) const;
+    size_t getNodeCount() const { return myNodes.size(); }
+
+private:
+    struct Node
+    {
+        Node* nw;
+        Node* ne;
+        Node* sw;
+        Node* se;
+        uint64_t population;
+        int level;
+        // Memoised centre advanced by 2^resultStep generations
+        int resultStep;
+        Node* result;
+    };
+
+    struct NodeKey
+    {
+        Node* nw;
+        Node* ne;
+        Node* sw;
+        Node* se;
+        bool operator==(const NodeKey& anOther) const
+        {
+            return nw == anOther.nw && ne == anOther.ne && sw == anOther.sw && se == anOther.se;
+        }
+    };
+
+    struct NodeKeyHash
+    {
+        size_t operator()(const NodeKey& aKey) const;
+    };
+
+    void reset();
+    Node* join(Node* aNW, Node* aNE, Node* aSW, Node* aSE);
+    Node* getEmpty(int aLevel);
+    Node* getCentre(Node* aNode);
+    Node* advanceBase(Node* aNode);
+    Node* advance(Node* aNode, int aStep);
+    void advanceTorus(int aStep);
+    Node* build(int aLevel, int x, int y, std::vector<sf::Vector2i>::iterator aBegin, std::vector<sf::Vector2i>::iterator anEnd);
+    void collect(const Node* aNode, int x, int y, std::vector<sf::Vector2i>& outCells) const;
+    void collectBounds(const Node* aNode, int x, int y, GenerationStats& outStats) const;
+
+    int myLevel;
+    std::deque<Node> myStorage;
+    std::unordered_map<NodeKey, Node*, NodeKeyHash> myNodes;
+    std::vector<Node*> myEmptyNodes;
+    Node myDead, myAlive;
+    Node* myRoot;
+};
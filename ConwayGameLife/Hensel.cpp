@@ -0,0 +1,470 @@
+#include "Hensel.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "BitOps.h"
+#include "Harness.h"
+#include "LifeEngine.h"
+#include "Log.h"
+#include "Parallel.h"
+#include "Pattern.h"
+#include "TileSet.h"
+
+static const int kNumRingMasks = 256;
+// Cells needing their letters up to which a word looks only those up
+static const int kScatteredLetterCells = 4;
+// Generations stepped through the table alone once most words needed it, before the counts are tried again
+static const int kTableOnlyGenerations = 16;
+// Letters each neighbour count takes, in the notation's own order
+static const char* const kLetters[9] = {"", "ce", "cekain", "cekainyqjr", "cekainyqjrtwz", "cekainyqjr", "cekain", "ce", ""};
+// One configuration of every letter of counts 1 to 4, ring bits clockwise from the north, N NE E SE S SW W NW.
+// Counts above 4 are the complements of those with the same letter.
+static const uint8_t kRepresentatives[5][13] =
+{
+    {},
+    {0x02, 0x01},
+    {0x0A, 0x05, 0x09, 0x03, 0x11, 0x22},
+    {0x2A, 0x15, 0x25, 0x07, 0x83, 0x0B, 0x29, 0x23, 0x43, 0x13},
+    {0xAA, 0x55, 0x4B, 0x0F, 0x1B, 0x8B, 0x2B, 0x27, 0x53, 0x17, 0x39, 0x63, 0x33}
+};
+// Neighbourhood bit of each ring bit, N NE E SE S SW W NW
+static const int kRingToNeighbourhood[8] = {1, 2, 5, 8, 7, 6, 3, 0};
+
+/// <summary>
+/// The letter of every ring configuration, 0 for counts 0 and 8 which have none
+/// </summary>
+static const char* getRingLetters()
+{
+    static char ourLetters[kNumRingMasks] = {};
+    static bool ourIsBuilt = false;
+    if(ourIsBuilt)
+        return ourLetters;
+    for(int count = 1; count <= 4; count++)
+    {
+        const int numLetters = (int)strlen(kLetters[count]);
+        for(int letter = 0; letter < numLetters; letter++)
+        {
+            // The eight rotations and reflections of the representative
+            uint32_t mask = kRepresentatives[count][letter];
+            for(int reflection = 0; reflection < 2; reflection++)
+            {
+                for(int rotation = 0; rotation < 4; rotation++)
+                {
+                    ourLetters[mask] = kLetters[count][letter];
+                    mask = ((mask << 2) | (mask >> 6)) & 0xFF;
+                }
+                uint32_t mirrored = 0;
+                for(int bit = 0; bit < 8; bit++)
+                {
+                    if((mask >> bit) & 1)
+                        mirrored |= 1u << ((8 - bit) & 7);
+                }
+                mask = mirrored;
+            }
+        }
+    }
+    for(int mask = 0; mask < kNumRingMasks; mask++)
+    {
+        if(popcount64((uint64_t)mask) > 4)
+            ourLetters[mask] = ourLetters[~mask & 0xFF];
+    }
+    ourIsBuilt = true;
+    return ourLetters;
+}
+
+HenselRule::HenselRule()
+{
+    parse("B3/S23");
+}
+
+bool HenselRule::operator==(const HenselRule& anOther) const
+{
+    return 0 == memcmp(myTable, anOther.myTable, sizeof(myTable));
+}
+
+bool HenselRule::parse(const std::string& aText)
+{
+    const char* ringLetters = getRingLetters();
+    // Next state by the cell's own state then its ring
+    bool isLive[2][kNumRingMasks] = {};
+    bool hasHalf[2] = {false, false};
+    int half = -1;
+    size_t i = 0;
+    while(i < aText.size())
+    {
+        const char c = (char)tolower((unsigned char)aText[i++]);
+        if('b' == c || 's' == c)
+        {
+            half = 'b' == c ? 0 : 1;
+            if(hasHalf[half])
+                return false;
+            hasHalf[half] = true;
+            continue;
+        }
+        if(('/' == c || '_' == c) && half >= 0)
+            continue;
+        if(c < '0' || c > '8' || half < 0)
+            return false;
+        const int count = c - '0';
+        const bool isNegated = i < aText.size() && '-' == aText[i];
+        if(isNegated)
+            i++;
+        std::string letters;
+        while(i < aText.size() && isalpha((unsigned char)aText[i]) && 'b' != tolower((unsigned char)aText[i]) &&
+              's' != tolower((unsigned char)aText[i]))
+        {
+            const char letter = (char)tolower((unsigned char)aText[i++]);
+            if(!strchr(kLetters[count], letter))
+                return false;
+            letters += letter;
+        }
+        if(isNegated && letters.empty())
+            return false;
+        for(int mask = 0; mask < kNumRingMasks; mask++)
+        {
+            if(popcount64((uint64_t)mask) != count)
+                continue;
+            const bool isListed = letters.find(ringLetters[mask]) != std::string::npos;
+            if(letters.empty() || isListed != isNegated)
+                isLive[half][mask] = true;
+        }
+    }
+    if(!hasHalf[0] || !hasHalf[1])
+        return false;
+    for(int neighbourhood = 0; neighbourhood < kNumNeighbourhoods; neighbourhood++)
+    {
+        int ring = 0;
+        for(int bit = 0; bit < 8; bit++)
+            ring |= ((neighbourhood >> kRingToNeighbourhood[bit]) & 1) << bit;
+        myTable[neighbourhood] = isLive[(neighbourhood >> 4) & 1][ring] ? 1 : 0;
+    }
+    return true;
+}
+
+/// <summary>
+/// The wide table of a rule, built by the first grid that needs it and shared by every later one
+/// </summary>
+static std::shared_ptr<const std::vector<uint8_t>> getWideTable(const HenselRule& aRule)
+{
+    static std::mutex ourMutex;
+    static std::map<std::string, std::shared_ptr<const std::vector<uint8_t>>> ourTables;
+    std::string key(HenselRule::kNumNeighbourhoods, '0');
+    for(int neighbourhood = 0; neighbourhood < HenselRule::kNumNeighbourhoods; neighbourhood++)
+        key[neighbourhood] = aRule.getNext(neighbourhood) ? '1' : '0';
+    std::lock_guard<std::mutex> lock(ourMutex);
+    std::shared_ptr<const std::vector<uint8_t>>& table = ourTables[key];
+    if(table)
+        return table;
+    const int lookupCells = HenselGrid::kLookupCells, windowWidth = lookupCells + 2;
+    std::vector<uint8_t> wide((size_t)1 << (3 * windowWidth));
+    for(size_t window = 0; window < wide.size(); window++)
+    {
+        uint8_t next = 0;
+        for(int cell = 0; cell < lookupCells; cell++)
+        {
+            int neighbourhood = 0;
+            for(int row = 0; row < 3; row++)
+                neighbourhood |= (int)((window >> (row * windowWidth + cell)) & 7) << (3 * row);
+            next |= (uint8_t)(aRule.getNext(neighbourhood) << cell);
+        }
+        wide[window] = next;
+    }
+    table = std::make_shared<const std::vector<uint8_t>>(std::move(wide));
+    return table;
+}
+
+HenselGrid::HenselGrid(int aWidth, int aHeight, const HenselRule& aRule, unsigned aNumThreads)
+    : myWidth(aWidth)
+    , myHeight(aHeight)
+    , myWordsPerRow(aWidth / 64)
+    , myRule(aRule)
+    , myNumThreads(std::max(1u, aNumThreads))
+    , myTableOnlyLeft(0)
+    , myCells((size_t)myWordsPerRow * aHeight, 0)
+    , myNextCells((size_t)myWordsPerRow * aHeight, 0)
+{
+    static_assert(64 % kLookupCells == 0, "lookups have to tile a word");
+    // Per count and state, if some and if all of the count's neighbourhoods come alive
+    bool isAnyLive[9][2] = {}, isAllLive[9][2];
+    for(int count = 0; count <= 8; count++)
+        isAllLive[count][0] = isAllLive[count][1] = true;
+    for(int neighbourhood = 0; neighbourhood < HenselRule::kNumNeighbourhoods; neighbourhood++)
+    {
+        const int state = (neighbourhood >> 4) & 1;
+        const int count = popcount64((uint64_t)neighbourhood) - state;
+        const bool isLive = myRule.getNext(neighbourhood);
+        isAnyLive[count][state] |= isLive;
+        isAllLive[count][state] &= isLive;
+    }
+    bool hasLetters = false;
+    for(int count = 0; count <= 8; count++)
+    {
+        CountTerm term;
+        for(int bit = 0; bit < 4; bit++)
+            term.bits[bit] = (count >> bit) & 1 ? ~0ull : 0;
+        term.deadNext = isAllLive[count][0] ? ~0ull : 0;
+        term.liveNext = isAllLive[count][1] ? ~0ull : 0;
+        term.deadLetters = isAnyLive[count][0] && !isAllLive[count][0] ? ~0ull : 0;
+        term.liveLetters = isAnyLive[count][1] && !isAllLive[count][1] ? ~0ull : 0;
+        if(term.deadNext | term.liveNext | term.deadLetters | term.liveLetters)
+            myCountTerms.push_back(term);
+        hasLetters |= 0 != (term.deadLetters | term.liveLetters);
+    }
+    if(hasLetters)
+        myWideTable = getWideTable(myRule);
+}
+
+void HenselGrid::load(const std::vector<sf::Vector2i>& someCells)
+{
+    std::fill(myCells.begin(), myCells.end(), 0);
+    for(auto& cell : someCells)
+        myCells[(size_t)cell.y * myWordsPerRow + (cell.x >> 6)] |= 1ull << (cell.x & 63);
+}
+
+void HenselGrid::save(std::vector<sf::Vector2i>& outCells) const
+{
+    saveWords(myCells.data(), myWordsPerRow, myHeight, outCells);
+}
+
+uint64_t HenselGrid::getPopulation() const
+{
+    uint64_t population = 0;
+    for(uint64_t word : myCells)
+        population += popcount64(word);
+    return population;
+}
+
+/// <summary>
+/// Bit planes of the neighbour count of every cell of a word, from the rows around it shifted so that bit x
+/// holds the west, own and east neighbour of cell x
+/// </summary>
+static inline void countNeighbours(const uint64_t someWest[3], const uint64_t someWords[3], const uint64_t someEast[3],
+                                   uint64_t outBits[4])
+{
+    // Rows above and below through full adders, the middle row through a half adder, as lifeWord does
+    const uint64_t sumA = someWest[0] ^ someWords[0] ^ someEast[0];
+    const uint64_t carryA = (someWest[0] & someWords[0]) | (someEast[0] & (someWest[0] ^ someWords[0]));
+    const uint64_t sumB = someWest[2] ^ someWords[2] ^ someEast[2];
+    const uint64_t carryB = (someWest[2] & someWords[2]) | (someEast[2] & (someWest[2] ^ someWords[2]));
+    const uint64_t sumM = someWest[1] ^ someEast[1], carryM = someWest[1] & someEast[1];
+    const uint64_t carryO = (sumA & sumB) | (sumM & (sumA ^ sumB));
+    // The four twos added up into twos, fours and eights
+    const uint64_t pairA = carryA ^ carryB, pairB = carryM ^ carryO;
+    const uint64_t bothA = carryA & carryB, bothB = carryM & carryO;
+    outBits[0] = sumA ^ sumB ^ sumM;
+    outBits[1] = pairA ^ pairB;
+    outBits[2] = bothA ^ bothB ^ (pairA & pairB);
+    outBits[3] = bothA & bothB;
+}
+
+/// <summary>
+/// Wide table index of the kLookupCells cells from bit p on, out of rows extended with their west neighbour at bit 0
+/// </summary>
+static inline uint64_t getWindow(uint64_t aTop, uint64_t aMiddle, uint64_t aBottom, int p)
+{
+    const int windowWidth = HenselGrid::kLookupCells + 2;
+    const uint64_t windowMask = (1ull << windowWidth) - 1;
+    return ((aTop >> p) & windowMask) | (((aMiddle >> p) & windowMask) << windowWidth) |
+           (((aBottom >> p) & windowMask) << (2 * windowWidth));
+}
+
+/// <summary>
+/// Wide table index of a word's last kLookupCells cells, whose window runs past the word into the east neighbour
+/// </summary>
+static inline uint64_t getEastWindow(const uint64_t someWords[3], const uint64_t someEastBits[3])
+{
+    const int lookupCells = HenselGrid::kLookupCells, windowWidth = lookupCells + 2, shift = 63 - lookupCells;
+    return ((someWords[0] >> shift) | (someEastBits[0] << (lookupCells + 1))) |
+           (((someWords[1] >> shift) | (someEastBits[1] << (lookupCells + 1))) << windowWidth) |
+           (((someWords[2] >> shift) | (someEastBits[2] << (lookupCells + 1))) << (2 * windowWidth));
+}
+
+void HenselGrid::step()
+{
+    const int wordsPerRow = myWordsPerRow, height = myHeight;
+    const int windowWidth = kLookupCells + 2;
+    const uint64_t lookupMask = (1ull << kLookupCells) - 1;
+    const uint8_t* table = myWideTable ? myWideTable->data() : nullptr;
+    const CountTerm* terms = myCountTerms.data();
+    const size_t numTerms = myCountTerms.size();
+    // Only a rule without B0 leaves empty space empty
+    const bool isEmptySkipped = !myRule.getNext(0);
+    const bool isTableOnly = myTableOnlyLeft > 0;
+    if(isTableOnly)
+        --myTableOnlyLeft;
+    // Words stepped, and stepped whole through the table, to decide on the next generations
+    std::atomic<uint64_t> numWords(0), numTableWords(0);
+    runStrips(height, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        uint64_t stripWords = 0, stripTableWords = 0;
+        for(int y = aBegin; y < anEnd; y++)
+        {
+            const uint64_t* rows[3] = {&myCells[(size_t)((y + height - 1) % height) * wordsPerRow],
+                                       &myCells[(size_t)y * wordsPerRow],
+                                       &myCells[(size_t)((y + 1) % height) * wordsPerRow]};
+            uint64_t* next = &myNextCells[(size_t)y * wordsPerRow];
+            for(int i = 0; i < wordsPerRow; i++)
+            {
+                const int west = i > 0 ? i - 1 : wordsPerRow - 1, east = i + 1 < wordsPerRow ? i + 1 : 0;
+                uint64_t words[3], westBits[3], eastBits[3];
+                for(int row = 0; row < 3; row++)
+                {
+                    words[row] = rows[row][i];
+                    westBits[row] = rows[row][west] >> 63;
+                    eastBits[row] = rows[row][east] & 1;
+                }
+                if(isEmptySkipped && 0 == (words[0] | words[1] | words[2] | westBits[0] | westBits[1] | westBits[2] |
+                                           eastBits[0] | eastBits[1] | eastBits[2]))
+                {
+                    next[i] = 0;
+                    continue;
+                }
+                ++stripWords;
+                // Bit 0 of an extended word is the west neighbour of cell 0, so cells p - 1 to p + kLookupCells start at bit p
+                const uint64_t top = (words[0] << 1) | westBits[0];
+                const uint64_t middle = (words[1] << 1) | westBits[1];
+                const uint64_t bottom = (words[2] << 1) | westBits[2];
+                uint64_t word = 0, needsLetters = ~0ull;
+                if(!isTableOnly)
+                {
+                    const uint64_t westOf[3] = {top, middle, bottom};
+                    const uint64_t eastOf[3] = {(words[0] >> 1) | (eastBits[0] << 63), (words[1] >> 1) | (eastBits[1] << 63),
+                                                (words[2] >> 1) | (eastBits[2] << 63)};
+                    uint64_t count[4];
+                    countNeighbours(westOf, words, eastOf, count);
+                    const uint64_t live = words[1], dead = ~live;
+                    needsLetters = 0;
+                    for(size_t t = 0; t < numTerms; t++)
+                    {
+                        const CountTerm& term = terms[t];
+                        const uint64_t isCount = ~((count[0] ^ term.bits[0]) | (count[1] ^ term.bits[1]) |
+                                                   (count[2] ^ term.bits[2]) | (count[3] ^ term.bits[3]));
+                        word |= isCount & ((dead & term.deadNext) | (live & term.liveNext));
+                        needsLetters |= isCount & ((dead & term.deadLetters) | (live & term.liveLetters));
+                    }
+                }
+                // The cells whose letters matter by table, kLookupCells at a time. Past a few of them the whole
+                // word goes through the table, a fixed run of lookups costing less than the mispredicted branches
+                // of a scattered one.
+                if(popcount64(needsLetters) > kScatteredLetterCells)
+                {
+                    ++stripTableWords;
+                    word = 0;
+                    int p = 0;
+                    for(; p + windowWidth <= 64; p += kLookupCells)
+                        word |= (uint64_t)table[getWindow(top, middle, bottom, p)] << p;
+                    word |= (uint64_t)table[getEastWindow(words, eastBits)] << p;
+                    needsLetters = 0;
+                }
+                while(needsLetters)
+                {
+                    const int p = ctz64(needsLetters) & ~(kLookupCells - 1);
+                    const uint64_t window = p + windowWidth <= 64 ? getWindow(top, middle, bottom, p) : getEastWindow(words, eastBits);
+                    word = (word & ~(lookupMask << p)) | ((uint64_t)table[window] << p);
+                    needsLetters &= ~(lookupMask << p);
+                }
+                next[i] = word;
+            }
+        }
+        numWords += stripWords;
+        numTableWords += stripTableWords;
+    });
+    myCells.swap(myNextCells);
+    // When most words end up in the table anyway the counts are wasted, so skip them for a while
+    if(!isTableOnly && numTableWords * 4 > numWords * 3)
+        myTableOnlyLeft = kTableOnlyGenerations;
+}
+
+void HenselGrid::stepNaive()
+{
+    const int width = myWidth, height = myHeight, wordsPerRow = myWordsPerRow;
+    auto get = [&](int x, int y)
+    {
+        x = (x + width) % width;
+        y = (y + height) % height;
+        return (int)((myCells[(size_t)y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1);
+    };
+    std::fill(myNextCells.begin(), myNextCells.end(), 0);
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            int neighbourhood = 0;
+            for(int row = 0; row < 3; row++)
+            {
+                for(int column = 0; column < 3; column++)
+                    neighbourhood |= get(x + column - 1, y + row - 1) << (3 * row + column);
+            }
+            if(myRule.getNext(neighbourhood))
+                myNextCells[(size_t)y * wordsPerRow + (x >> 6)] |= 1ull << (x & 63);
+        }
+    }
+    myCells.swap(myNextCells);
+}
+
+/// <summary>
+/// Seconds a generation of B3/S23 takes on one of the shared engines, over the same start
+/// </summary>
+static double timeEngine(EngineType aType, int aSide, const std::vector<sf::Vector2i>& someCells, int aGenerations,
+                         std::vector<sf::Vector2i>& outCells)
+{
+    std::unique_ptr<LifeEngine> engine = createEngine(aType, aSide);
+    engine->load(someCells);
+    const double seconds = timePerCall(aGenerations, [&engine]() { engine->step(1); });
+    engine->save(outCells);
+    return seconds;
+}
+
+int runHensel(int argc, char* argv[])
+{
+    HenselRule rule;
+    if(argc < 3 || !rule.parse(argv[0]))
+    {
+        LOG_INFO("usage: --hensel <rule like B2-a/S12> <side, a multiple of 64> <pattern.rle | density> [generations] [threads] [seed]\n");
+        return 1;
+    }
+    const int side = atoi(argv[1]);
+    const int generations = argc > 3 ? atoi(argv[3]) : 100;
+    const unsigned numThreads = argc > 4 ? (unsigned)atoi(argv[4]) : std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t seed = argc > 5 ? strtoull(argv[5], nullptr, 10) : 0;
+    if(side < 64 || 0 != side % 64 || generations < 1)
+    {
+        LOG_ERROR("the side has to be a multiple of 64\n");
+        return 1;
+    }
+    std::vector<sf::Vector2i> cells;
+    makeBoard(argv[2], side, seed, cells);
+    HenselGrid grid(side, side, rule, numThreads);
+    grid.load(cells);
+    LOG_INFO("%s on %dx%d, population %llu, %u threads\n", argv[0], side, side, (unsigned long long)grid.getPopulation(), numThreads);
+    runWithReports(grid, generations, (double)side * side);
+
+    // The same start through the table, the naive step and plain B3/S23 on the shared engines
+    const int numChecked = std::min(generations, kCheckGenerations);
+    HenselGrid table(side, side, rule, numThreads), naive(side, side, rule, numThreads);
+    table.load(cells);
+    naive.load(cells);
+    double tableSeconds, naiveSeconds;
+    bool isMatch = checkAgainstNaive(table, naive, numChecked, tableSeconds, naiveSeconds);
+    std::vector<sf::Vector2i> sparseCells, denseCells, tableCells;
+    const double sparseSeconds = timeEngine(EngineType::SparseSet, side, cells, numChecked, sparseCells);
+    const double denseSeconds = timeEngine(EngineType::DenseBits, side, cells, numChecked, denseCells);
+    LOG_INFO("table %.3f ms/gen, B3/S23 through %s %.3f ms/gen and %s %.3f ms/gen, the table at %.2fx and %.2fx their speed\n",
+             tableSeconds * 1e3, getEngineName(EngineType::SparseSet), sparseSeconds * 1e3, getEngineName(EngineType::DenseBits),
+             denseSeconds * 1e3, sparseSeconds / tableSeconds, denseSeconds / tableSeconds);
+    if(rule == HenselRule())
+    {
+        table.save(tableCells);
+        std::sort(tableCells.begin(), tableCells.end(), TileComparator());
+        std::sort(denseCells.begin(), denseCells.end(), TileComparator());
+        isMatch = isMatch && tableCells == denseCells;
+    }
+    LOG_INFO("%d generations %s the naive step%s, the table %.1fx faster than it\n", numChecked, isMatch ? "match" : "MISMATCH",
+             rule == HenselRule() ? " and BitGrid" : "", naiveSeconds / tableSeconds);
+    return isMatch ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Range r totalistic rule over the (2r + 1)^2 box around a cell
+/// </summary>
+struct LtlRule
+{
+    static const int kMaxRadius = 50;
+
+    int radius = 1;
+    // If the cell itself counts towards its neighbourhood
+    bool isCentreCounted = false;
+    // Inclusive count ranges for a live cell to stay and a dead one to be born
+    int surviveMin = 2, surviveMax = 3;
+    int birthMin = 3, birthMax = 3;
+};
+
+/// <summary>
+/// Parse a rule in Golly's notation, "R5,C0,M1,S34..58,B34..45,NM" for Bosco's rule.
+/// Only two state rules (C0 or C2) over the Moore box (NM) are understood.
+/// </summary>
+/// <returns>If the text was such a rule</returns>
+bool parseLtlRule(const std::string& aText, LtlRule& outRule);
+
+/// <summary>
+/// Larger than Life on a square torus. Each generation first builds a summed-area table of the board,
+/// padded by the radius with wrapped cells, then reads every cell's box count from four of its entries,
+/// so a cell costs the same whatever the radius. Rows of both passes are split over threads and their
+/// inner loops run along contiguous rows for the compiler to vectorise.
+/// </summary>
+class LtlGrid
+{
+public:
+    LtlGrid(int aSide, const LtlRule& aRule, unsigned aNumThreads);
+
+    int getSide() const { return mySide; }
+    const std::vector<uint8_t>& getCells() const { return myCells; }
+
+    void load(const std::vector<sf::Vector2i>& someCells);
+    void save(std::vector<sf::Vector2i>& outCells) const;
+    uint64_t getPopulation() const;
+
+    void step();
+    /// <summary>
+    /// One generation counting the box cell by cell, (2r + 1)^2 reads per cell, the reference for step
+    /// </summary>
+    void stepNaive();
+
+private:
+    void buildTable();
+
+    int mySide;
+    LtlRule myRule;
+    unsigned myNumThreads;
+    std::vector<uint8_t> myCells, myNextCells;
+    // Padded side + 1 entries a row, the first row and column zero
+    std::vector<uint32_t> myTable;
+    int myTableStride;
+};
+
+/// <summary>
+/// Command line entry, "--ltl <rule> <side> <pattern.rle | density> [generations] [threads] [seed]".
+/// Runs the board, logging the population as it goes and the time per generation, then checks and times
+/// the first generations against the naive count.
+/// </summary>
+int runLargerThanLife(int argc, char* argv[]);
@@ -0,0 +1,352 @@
+#include "Lenia.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include "Harness.h"
+#include "Log.h"
+#include "Parallel.h"
+
+// Seeded patches are this many radii across, and cover about this share of the board
+static const float kPatchRadii = 2.f;
+static const float kPatchCover = 0.25f;
+// Generations timed on the direct sum, per ten on the FFT, it is that much slower
+static const int kDirectShare = 10;
+
+/// <summary>
+/// Logistic step of width anAlpha centred on aCentre
+/// </summary>
+static inline float sigmoid(float x, float aCentre, float anAlpha)
+{
+    return 1.f / (1.f + std::exp(-(x - aCentre) * 4.f / anAlpha));
+}
+
+ContinuousRule makeContinuousRule(ContinuousType aType, int aRadius)
+{
+    ContinuousRule rule;
+    rule.type = aType;
+    rule.radius = aRadius;
+    if(ContinuousType::SmoothLife == aType)
+        rule.dt = 1.f;
+    return rule;
+}
+
+bool isContinuousSideSupported(int aSide, const ContinuousRule& aRule)
+{
+    return aSide >= 2 && 0 == (aSide & (aSide - 1)) && aSide > 2 * (aRule.radius + 1) && aRule.radius >= 1;
+}
+
+ContinuousGrid::ContinuousGrid(int aSide, const ContinuousRule& aRule, unsigned aNumThreads)
+    : mySide(aSide)
+    , myRule(aRule)
+    , myNumThreads(std::max(1u, aNumThreads))
+    , myFft(aSide, aSide, myNumThreads)
+    , myCells((size_t)aSide * aSide, 0.f)
+    , mySpectrum(myFft.getSpectrumSize())
+    , myProduct(myFft.getSpectrumSize())
+{
+    const float radius = (float)aRule.radius;
+    if(ContinuousType::Lenia == aRule.type)
+    {
+        // Smooth bump over the ring, zero at the centre and at the radius
+        addKernel([radius](float aDistance)
+        {
+            const float r = aDistance / radius;
+            return r > 0.f && r < 1.f ? std::exp(4.f - 1.f / (r * (1.f - r))) : 0.f;
+        });
+    }
+    else
+    {
+        // Disk of a third of the radius and the annulus around it, edges antialiased over a cell
+        const float inner = radius / 3.f;
+        auto disk = [](float aDistance, float aRadius) { return std::max(0.f, std::min(1.f, aRadius + 0.5f - aDistance)); };
+        addKernel([disk, inner](float aDistance) { return disk(aDistance, inner); });
+        addKernel([disk, inner, radius](float aDistance) { return disk(aDistance, radius) - disk(aDistance, inner); });
+    }
+}
+
+template<typename F>
+void ContinuousGrid::addKernel(F aWeight)
+{
+    std::vector<Tap> taps;
+    double total = 0.0;
+    const int reach = myRule.radius + 1;
+    for(int dy = -reach; dy <= reach; dy++)
+    {
+        for(int dx = -reach; dx <= reach; dx++)
+        {
+            const float weight = aWeight(std::sqrt((float)(dx * dx + dy * dy)));
+            if(weight > 0.f)
+            {
+                taps.push_back(Tap{ dx, dy, weight });
+                total += weight;
+            }
+        }
+    }
+    // Normalised so the potential is a filling between 0 and 1
+    std::vector<float> image((size_t)mySide * mySide, 0.f);
+    for(auto& tap : taps)
+    {
+        tap.weight = (float)(tap.weight / total);
+        image[(size_t)((tap.dy + mySide) % mySide) * mySide + (tap.dx + mySide) % mySide] = tap.weight;
+    }
+    myKernelSpectra.emplace_back(myFft.getSpectrumSize());
+    myFft.forward(image.data(), myKernelSpectra.back().data());
+    myKernelTaps.push_back(taps);
+    myPotentials.emplace_back((size_t)mySide * mySide, 0.f);
+}
+
+void ContinuousGrid::seed(uint64_t aSeed)
+{
+    std::mt19937_64 random(aSeed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::fill(myCells.begin(), myCells.end(), 0.f);
+    const int patch = std::max(1, (int)(kPatchRadii * myRule.radius));
+    const int numPatches = std::max(1, (int)(kPatchCover * mySide * mySide / (patch * patch)));
+    for(int i = 0; i < numPatches; i++)
+    {
+        const int left = random() % mySide, top = random() % mySide;
+        for(int y = 0; y < patch; y++)
+        {
+            for(int x = 0; x < patch; x++)
+                myCells[(size_t)((top + y) % mySide) * mySide + (left + x) % mySide] = unit(random);
+        }
+    }
+}
+
+void ContinuousGrid::step()
+{
+    myFft.forward(myCells.data(), mySpectrum.data());
+    const int spectrumWidth = myFft.getSpectrumWidth();
+    for(size_t kernel = 0; kernel < myKernelSpectra.size(); kernel++)
+    {
+        const std::complex<float>* kernelSpectrum = myKernelSpectra[kernel].data();
+        runStrips(mySide, myNumThreads, [&](int aBegin, int anEnd)
+        {
+            for(size_t i = (size_t)aBegin * spectrumWidth; i < (size_t)anEnd * spectrumWidth; i++)
+            {
+                const std::complex<float>& a = mySpectrum[i];
+                const std::complex<float>& b = kernelSpectrum[i];
+                myProduct[i] = std::complex<float>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+            }
+        });
+        myFft.inverse(myProduct.data(), myPotentials[kernel].data());
+    }
+    grow();
+}
+
+void ContinuousGrid::stepDirect()
+{
+    const int side = mySide, mask = mySide - 1;
+    for(size_t kernel = 0; kernel < myKernelTaps.size(); kernel++)
+    {
+        const std::vector<Tap>& taps = myKernelTaps[kernel];
+        float* potential = myPotentials[kernel].data();
+        // A shifted source row per tap added along the whole output row, in two runs either side of the wrap
+        runStrips(side, myNumThreads, [&](int aBegin, int anEnd)
+        {
+            for(int y = aBegin; y < anEnd; y++)
+            {
+                float* out = potential + (size_t)y * side;
+                std::fill(out, out + side, 0.f);
+                for(auto& tap : taps)
+                {
+                    const float* source = myCells.data() + (size_t)((y + tap.dy) & mask) * side;
+                    const int shift = (tap.dx + side) & mask, split = side - shift;
+                    const float weight = tap.weight;
+                    for(int x = 0; x < split; x++)
+                        out[x] += weight * source[x + shift];
+                    for(int x = split; x < side; x++)
+                        out[x] += weight * source[x + shift - side];
+                }
+            }
+        });
+    }
+    grow();
+}
+
+void ContinuousGrid::grow()
+{
+    const ContinuousRule& rule = myRule;
+    runStrips(mySide, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        const size_t begin = (size_t)aBegin * mySide, end = (size_t)anEnd * mySide;
+        if(ContinuousType::Lenia == rule.type)
+        {
+            const float* potential = myPotentials[0].data();
+            const float scale = -1.f / (2.f * rule.sigma * rule.sigma);
+            for(size_t i = begin; i < end; i++)
+            {
+                const float offset = potential[i] - rule.mu;
+                const float growth = 2.f * std::exp(offset * offset * scale) - 1.f;
+                myCells[i] = std::max(0.f, std::min(1.f, myCells[i] + rule.dt * growth));
+            }
+            return;
+        }
+        const float* inner = myPotentials[0].data();
+        const float* outer = myPotentials[1].data();
+        for(size_t i = begin; i < end; i++)
+        {
+            // Alive inside the disk moves the interval from the birth to the death bounds
+            const float alive = sigmoid(inner[i], 0.5f, rule.alphaM);
+            const float low = rule.birth1 * (1.f - alive) + rule.death1 * alive;
+            const float high = rule.birth2 * (1.f - alive) + rule.death2 * alive;
+            const float next = sigmoid(outer[i], low, rule.alphaN) * (1.f - sigmoid(outer[i], high, rule.alphaN));
+            myCells[i] = rule.dt >= 1.f ? next : std::max(0.f, std::min(1.f, myCells[i] + rule.dt * (2.f * next - 1.f)));
+        }
+    });
+}
+
+double ContinuousGrid::getMass() const
+{
+    double mass = 0.0;
+    for(float cell : myCells)
+        mass += cell;
+    return mass;
+}
+
+/// <summary>
+/// Dark blue through red to pale yellow, one colour per 8 bit level of a cell
+/// </summary>
+static void makePalette(sf::Color* outColors)
+{
+    for(int i = 0; i < 256; i++)
+    {
+        const float t = i / 255.f;
+        outColors[i] = sf::Color((sf::Uint8)(255 * std::min(1.f, 2.f * t)), (sf::Uint8)(255 * std::max(0.f, 2.f * t - 1.f)),
+                                 (sf::Uint8)(255 * (0.3f * (1.f - t) + 0.6f * std::max(0.f, 2.f * t - 1.f))));
+    }
+}
+
+int runContinuous(int argc, char* argv[])
+{
+    const int side = argc > 0 ? atoi(argv[0]) : 256;
+    const ContinuousType type = argc > 1 && std::string("smoothlife") == argv[1] ? ContinuousType::SmoothLife : ContinuousType::Lenia;
+    const int radius = argc > 2 ? atoi(argv[2]) : (ContinuousType::SmoothLife == type ? 12 : 13);
+    const unsigned numThreads = argc > 3 ? (unsigned)atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : 0;
+    const ContinuousRule rule = makeContinuousRule(type, radius);
+    if(!isContinuousSideSupported(side, rule))
+    {
+        LOG_INFO("usage: --lenia [power of two side above twice the radius] [lenia|smoothlife] [radius] [threads] [seed]\n");
+        return 1;
+    }
+    ContinuousGrid grid(side, rule, numThreads);
+    grid.seed(seed);
+
+    const std::string kStrTitle = ContinuousType::Lenia == type ? "Lenia" : "SmoothLife";
+    sf::RenderWindow window(sf::VideoMode(800, 800), kStrTitle);
+    window.setFramerateLimit(60);
+    // SFML textures hold 8 bits a channel, cells are quantised through the palette on the way up
+    sf::Texture texture;
+    texture.create(side, side);
+    std::vector<sf::Uint8> pixels((size_t)4 * side * side);
+    sf::Color palette[256];
+    makePalette(palette);
+    sf::Sprite sprite(texture);
+    sprite.setScale(800.f / side, 800.f / side);
+    bool isPaused = false;
+    uint64_t generation = 0;
+    int numSteps = 0;
+    sf::Clock reportClock;
+    while(window.isOpen())
+    {
+        sf::Event event;
+        while(window.pollEvent(event))
+        {
+            if(sf::Event::Closed == event.type || (sf::Event::KeyPressed == event.type && sf::Keyboard::Escape == event.key.code))
+                window.close();
+            if(sf::Event::KeyPressed != event.type)
+                continue;
+            switch(event.key.code)
+            {
+            case sf::Keyboard::Space:
+                isPaused = !isPaused;
+                break;
+            case sf::Keyboard::N:
+                grid.step();
+                ++generation;
+                break;
+            case sf::Keyboard::R:
+                grid.seed(++seed);
+                generation = 0;
+                break;
+            default:
+                break;
+            }
+        }
+        if(!isPaused)
+        {
+            grid.step();
+            ++generation;
+            ++numSteps;
+        }
+        const std::vector<float>& cells = grid.getCells();
+        for(size_t i = 0; i < cells.size(); i++)
+        {
+            const sf::Color& color = palette[(int)(cells[i] * 255.f + 0.5f)];
+            pixels[4 * i] = color.r;
+            pixels[4 * i + 1] = color.g;
+            pixels[4 * i + 2] = color.b;
+            pixels[4 * i + 3] = 255;
+        }
+        texture.update(pixels.data());
+        if(reportClock.getElapsedTime() > sf::seconds(0.5f))
+        {
+            char title[128];
+            snprintf(title, sizeof(title), "%s, generation %llu, %.1f gen/s, mass %.0f%s", kStrTitle.c_str(), (unsigned long long)generation,
+                     numSteps / reportClock.restart().asSeconds(), grid.getMass(), isPaused ? " (paused)" : "");
+            window.setTitle(title);
+            numSteps = 0;
+        }
+        window.clear();
+        window.draw(sprite);
+        window.display();
+    }
+    return 0;
+}
+
+int runContinuousBenchmark(int argc, char* argv[])
+{
+    const int side = argc > 0 ? atoi(argv[0]) : 512;
+    const int radius = argc > 1 ? atoi(argv[1]) : 13;
+    const int generations = argc > 2 ? atoi(argv[2]) : 20;
+    const unsigned numThreads = argc > 3 ? (unsigned)atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    if(!isContinuousSideSupported(side, makeContinuousRule(ContinuousType::Lenia, radius)) || generations < 1)
+    {
+        LOG_INFO("usage: --lenia-bench [power of two side above twice the radius] [radius] [generations] [threads]\n");
+        return 1;
+    }
+    const double numCells = (double)side * side;
+    for(ContinuousType type : { ContinuousType::Lenia, ContinuousType::SmoothLife })
+    {
+        const ContinuousRule rule = makeContinuousRule(type, radius);
+        ContinuousGrid grid(side, rule, numThreads);
+        grid.seed(0);
+        // Into the running state before timing, fresh noise is not typical
+        for(int i = 0; i < 10; i++)
+            grid.step();
+        ContinuousGrid direct(side, rule, numThreads);
+        direct.getCells() = grid.getCells();
+        LOG_INFO("%s radius %d on %dx%d, %u threads\n", ContinuousType::Lenia == type ? "lenia" : "smoothlife", radius, side, side, numThreads);
+
+        // One step of each from the same board, the FFT only rounds differently
+        ContinuousGrid check(side, rule, numThreads);
+        check.getCells() = grid.getCells();
+        check.step();
+        direct.stepDirect();
+        float difference = 0.f;
+        for(size_t i = 0; i < direct.getCells().size(); i++)
+            difference = std::max(difference, std::fabs(direct.getCells()[i] - check.getCells()[i]));
+
+        const double fftSeconds = timePerCall(generations, [&grid]() { grid.step(); });
+        const double directSeconds = timePerCall(std::max(1, generations / kDirectShare), [&direct]() { direct.stepDirect(); });
+        LOG_INFO("%-24s %10.3f ms/gen %12.4g cells/s\n", "fft", fftSeconds * 1e3, numCells / fftSeconds);
+        LOG_INFO("%-24s %10.3f ms/gen %12.4g cells/s\n", "direct", directSeconds * 1e3, numCells / directSeconds);
+        LOG_INFO("%-24s %10.1fx faster, largest difference after a step %.3g\n", "", directSeconds / fftSeconds, difference);
+    }
+    return 0;
+}
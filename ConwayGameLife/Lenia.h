@@ -0,0 +1,99 @@
+#pragma once
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include "Fft.h"
+
+enum ContinuousType
+{
+    Lenia, // One smooth ring kernel, cells grow by a gaussian of its weighted sum
+    SmoothLife // Inner disk and outer annulus fillings through smoothed birth and death intervals
+};
+
+/// <summary>
+/// Parameters of a continuous rule, the defaults are Lenia's orbium and Rafler's SmoothLife
+/// </summary>
+struct ContinuousRule
+{
+    ContinuousType type = ContinuousType::Lenia;
+    int radius = 13;
+    // Share of the growth applied per step, 1 or more replaces the cells outright
+    float dt = 0.1f;
+    // Lenia growth centre and width
+    float mu = 0.15f, sigma = 0.015f;
+    // SmoothLife birth and death intervals of the annulus filling, and the steepness of the interval edges
+    float birth1 = 0.278f, birth2 = 0.365f, death1 = 0.267f, death2 = 0.445f;
+    float alphaN = 0.028f, alphaM = 0.147f;
+};
+
+ContinuousRule makeContinuousRule(ContinuousType aType, int aRadius);
+
+/// <summary>
+/// Board side the engine can run a rule on, a power of two wider than the kernel
+/// </summary>
+bool isContinuousSideSupported(int aSide, const ContinuousRule& aRule);
+
+/// <summary>
+/// Continuous state relatives of Life on a square torus, cells from 0 to 1. Each step convolves the board
+/// with the rule's large radius kernels by multiplying spectra, O(log n) per cell whatever the radius,
+/// where the direct sum costs one multiply per kernel cell.
+/// </summary>
+class ContinuousGrid
+{
+public:
+    ContinuousGrid(int aSide, const ContinuousRule& aRule, unsigned aNumThreads);
+
+    int getSide() const { return mySide; }
+    const ContinuousRule& getRule() const { return myRule; }
+    const std::vector<float>& getCells() const { return myCells; }
+    std::vector<float>& getCells() { return myCells; }
+
+    /// <summary>
+    /// Random patches about a kernel across, the rest of the board empty
+    /// </summary>
+    void seed(uint64_t aSeed);
+
+    /// <summary>
+    /// One step with the kernels applied through the FFT
+    /// </summary>
+    void step();
+    /// <summary>
+    /// One step with the kernels summed cell by cell, the reference the FFT is measured and checked against
+    /// </summary>
+    void stepDirect();
+
+    double getMass() const;
+
+private:
+    struct Tap
+    {
+        int dx, dy;
+        float weight;
+    };
+
+    template<typename F>
+    void addKernel(F aWeight);
+    void grow();
+
+    int mySide;
+    ContinuousRule myRule;
+    unsigned myNumThreads;
+    RealFft2D myFft;
+    std::vector<float> myCells;
+    std::vector<std::complex<float>> mySpectrum, myProduct;
+    // One kernel for Lenia, the disk then the annulus for SmoothLife
+    std::vector<std::vector<std::complex<float>>> myKernelSpectra;
+    std::vector<std::vector<Tap>> myKernelTaps;
+    std::vector<std::vector<float>> myPotentials;
+};
+
+/// <summary>
+/// Command line entry, "--lenia [side] [lenia|smoothlife] [radius] [threads] [seed]", a window running the board
+/// </summary>
+int runContinuous(int argc, char* argv[]);
+
+/// <summary>
+/// Command line entry, "--lenia-bench [side] [radius] [generations] [threads]", FFT against direct convolution
+/// for both rules, with the largest difference between the two after a step
+/// </summary>
+int runContinuousBenchmark(int argc, char* argv[]);
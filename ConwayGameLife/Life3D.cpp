@@ -0,0 +1,464 @@
+#include "Life3D.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "BitOps.h"
+#include "Harness.h"
+#include "Log.h"
+#include "Parallel.h"
+
+// Slices of a 3x3 plane sum, up to 9
+static const int kPlaneSlices = 4;
+// Slices of the cube sum with the cell itself, up to 27
+static const int kCubeSlices = 5;
+// Side of the cube the benchmark checks against the naive count
+static const int kCheckSide = 64;
+// Share of the side the seeded cube spans, and its density
+static const float kSeedExtent = 0.25f;
+static const float kSeedDensity = 0.3f;
+static const int kWindowSide = 800;
+
+/// <summary>
+/// "4-5" into its two ends, a single number is a range of one
+/// </summary>
+static bool parseCountRange(const std::string& aText, int& outMin, int& outMax)
+{
+    char* end = nullptr;
+    outMin = (int)strtol(aText.c_str(), &end, 10);
+    if(end == aText.c_str() || '-' == aText[0])
+        return false;
+    outMax = outMin;
+    if(0 == *end)
+        return true;
+    if('-' != *end)
+        return false;
+    const char* second = end + 1;
+    outMax = (int)strtol(second, &end, 10);
+    return end != second && '-' != *second && 0 == *end;
+}
+
+bool parseLife3DRule(const std::string& aText, Life3DRule& outRule)
+{
+    int counts[4];
+    const size_t slash = aText.find('/');
+    if(std::string::npos != slash)
+    {
+        if(!parseCountRange(aText.substr(0, slash), counts[0], counts[1]) || !parseCountRange(aText.substr(slash + 1), counts[2], counts[3]))
+            return false;
+    }
+    else if(std::string::npos == aText.find(','))
+    {
+        if(4 != aText.size())
+            return false;
+        for(int i = 0; i < 4; i++)
+        {
+            if(aText[i] < '0' || aText[i] > '9')
+                return false;
+            counts[i] = aText[i] - '0';
+        }
+    }
+    else
+    {
+        std::stringstream stream(aText);
+        std::string token;
+        int numCounts = 0;
+        while(std::getline(stream, token, ','))
+        {
+            char* end = nullptr;
+            const long count = strtol(token.c_str(), &end, 10);
+            if(numCounts >= 4 || end == token.c_str() || 0 != *end)
+                return false;
+            counts[numCounts++] = (int)count;
+        }
+        if(4 != numCounts)
+            return false;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        if(counts[i] < 0 || counts[i] > 26)
+            return false;
+    }
+    if(counts[0] > counts[1] || counts[2] > counts[3])
+        return false;
+    outRule.surviveMin = counts[0];
+    outRule.surviveMax = counts[1];
+    outRule.birthMin = counts[2];
+    outRule.birthMax = counts[3];
+    return true;
+}
+
+/// <summary>
+/// The rule in four digits, or as two ranges once a count is above 9
+/// </summary>
+static std::string getRuleName(const Life3DRule& aRule)
+{
+    const bool isWide = aRule.surviveMax > 9 || aRule.birthMax > 9;
+    char name[32];
+    snprintf(name, sizeof(name), isWide ? "%d-%d/%d-%d" : "%d%d%d%d", aRule.surviveMin, aRule.surviveMax, aRule.birthMin, aRule.birthMax);
+    return name;
+}
+
+/// <summary>
+/// Bitsliced a + b of aNumSlices slices each, outSum takes one slice more
+/// </summary>
+static inline void addSlices(const uint64_t* a, const uint64_t* b, int aNumSlices, uint64_t* outSum)
+{
+    uint64_t carry = 0;
+    for(int k = 0; k < aNumSlices; k++)
+    {
+        const uint64_t half = a[k] ^ b[k];
+        outSum[k] = half ^ carry;
+        carry = (a[k] & b[k]) | (carry & half);
+    }
+    outSum[aNumSlices] = carry;
+}
+
+/// <summary>
+/// Cells whose bitsliced value is at least a constant, compared from the top slice down
+/// </summary>
+static inline uint64_t isAtLeast(const uint64_t* someSlices, int aNumSlices, int aValue)
+{
+    if(aValue >= (1 << aNumSlices))
+        return 0;
+    uint64_t isGreater = 0, isEqual = ~0ULL;
+    for(int k = aNumSlices - 1; k >= 0; k--)
+    {
+        if((aValue >> k) & 1)
+        {
+            isEqual &= someSlices[k];
+        }
+        else
+        {
+            isGreater |= isEqual & someSlices[k];
+            isEqual &= ~someSlices[k];
+        }
+    }
+    return isGreater | isEqual;
+}
+
+static inline uint64_t isInRange(const uint64_t* someSlices, int aNumSlices, int aMin, int aMax)
+{
+    return isAtLeast(someSlices, aNumSlices, aMin) & ~isAtLeast(someSlices, aNumSlices, aMax + 1);
+}
+
+Life3DGrid::Life3DGrid(int aSide, const Life3DRule& aRule, unsigned aNumThreads)
+    : mySide(aSide)
+    , myWordsPerRow(aSide / 64)
+    , myRule(aRule)
+    , myNumThreads(std::max(1u, aNumThreads))
+    , myCells((size_t)aSide * aSide * (aSide / 64), 0)
+    , myNextCells(myCells.size(), 0)
+{
+}
+
+void Life3DGrid::clear()
+{
+    std::fill(myCells.begin(), myCells.end(), 0);
+}
+
+void Life3DGrid::set(int x, int y, int z, bool isLive)
+{
+    uint64_t& word = myCells[((size_t)z * mySide + y) * myWordsPerRow + (x >> 6)];
+    const uint64_t bit = 1ULL << (x & 63);
+    word = isLive ? word | bit : word & ~bit;
+}
+
+uint64_t Life3DGrid::getPopulation() const
+{
+    uint64_t population = 0;
+    for(uint64_t word : myCells)
+        population += popcount64(word);
+    return population;
+}
+
+void Life3DGrid::seed(float aDensity, int anExtent, uint64_t aSeed)
+{
+    std::mt19937_64 random(aSeed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    clear();
+    const int first = (mySide - anExtent) / 2;
+    for(int z = first; z < first + anExtent; z++)
+    {
+        for(int y = first; y < first + anExtent; y++)
+        {
+            for(int x = first; x < first + anExtent; x++)
+            {
+                if(unit(random) < aDensity)
+                    set(x, y, z, true);
+            }
+        }
+    }
+}
+
+void Life3DGrid::sumPlane(int z, uint64_t* outSums, std::vector<uint64_t>& someRowSums) const
+{
+    const int side = mySide, wordsPerRow = myWordsPerRow;
+    // Each cell and its two neighbours along x, two slices
+    for(int y = 0; y < side; y++)
+    {
+        const uint64_t* row = getRow(y, z);
+        uint64_t* sums = &someRowSums[(size_t)y * wordsPerRow * 2];
+        for(int i = 0; i < wordsPerRow; i++)
+        {
+            const uint64_t west = (row[i] << 1) | (row[i > 0 ? i - 1 : wordsPerRow - 1] >> 63);
+            const uint64_t east = (row[i] >> 1) | (row[i + 1 < wordsPerRow ? i + 1 : 0] << 63);
+            const uint64_t half = west ^ row[i];
+            sums[2 * i] = half ^ east;
+            sums[2 * i + 1] = (west & row[i]) | (east & half);
+        }
+    }
+    // Then three rows of those
+    for(int y = 0; y < side; y++)
+    {
+        const uint64_t* above = &someRowSums[(size_t)((y + side - 1) % side) * wordsPerRow * 2];
+        const uint64_t* center = &someRowSums[(size_t)y * wordsPerRow * 2];
+        const uint64_t* below = &someRowSums[(size_t)((y + 1) % side) * wordsPerRow * 2];
+        uint64_t* sums = &outSums[(size_t)y * wordsPerRow * kPlaneSlices];
+        for(int i = 0; i < wordsPerRow; i++)
+        {
+            uint64_t pair[3];
+            addSlices(&above[2 * i], &center[2 * i], 2, pair);
+            const uint64_t third[3] = {below[2 * i], below[2 * i + 1], 0};
+            addSlices(pair, third, 3, &sums[kPlaneSlices * i]);
+        }
+    }
+}
+
+void Life3DGrid::step()
+{
+    const int side = mySide, wordsPerRow = myWordsPerRow;
+    const size_t planeWords = (size_t)side * wordsPerRow;
+    // The cube sum counts the cell itself, so a live cell's neighbours are one less
+    const int surviveMin = myRule.surviveMin + 1, surviveMax = myRule.surviveMax + 1;
+    const int birthMin = myRule.birthMin, birthMax = myRule.birthMax;
+    runStrips(side, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        // Plane sums of z - 1, z and z + 1 in turn, each computed once per slab
+        std::vector<uint64_t> planeSums[3];
+        for(auto& sums : planeSums)
+            sums.resize(planeWords * kPlaneSlices);
+        std::vector<uint64_t> rowSums(planeWords * 2);
+        sumPlane((aBegin + side - 1) % side, planeSums[(aBegin + 2) % 3].data(), rowSums);
+        sumPlane(aBegin, planeSums[aBegin % 3].data(), rowSums);
+        for(int z = aBegin; z < anEnd; z++)
+        {
+            sumPlane((z + 1) % side, planeSums[(z + 1) % 3].data(), rowSums);
+            const uint64_t* back = planeSums[(z + 2) % 3].data();
+            const uint64_t* middle = planeSums[z % 3].data();
+            const uint64_t* front = planeSums[(z + 1) % 3].data();
+            const uint64_t* cells = &myCells[(size_t)z * planeWords];
+            uint64_t* next = &myNextCells[(size_t)z * planeWords];
+            for(size_t word = 0; word < planeWords; word++)
+            {
+                const size_t slice = word * kPlaneSlices;
+                uint64_t pair[kPlaneSlices + 1], total[kCubeSlices + 1];
+                addSlices(&back[slice], &middle[slice], kPlaneSlices, pair);
+                const uint64_t third[kCubeSlices] = {front[slice], front[slice + 1], front[slice + 2], front[slice + 3], 0};
+                addSlices(pair, third, kCubeSlices, total);
+                const uint64_t isLive = cells[word];
+                next[word] = (isLive & isInRange(total, kCubeSlices, surviveMin, surviveMax)) |
+                             (~isLive & isInRange(total, kCubeSlices, birthMin, birthMax));
+            }
+        }
+    });
+    myCells.swap(myNextCells);
+}
+
+void Life3DGrid::stepNaive()
+{
+    const int side = mySide;
+    std::vector<uint64_t> next(myCells.size(), 0);
+    runStrips(side, myNumThreads, [&](int aBegin, int anEnd)
+    {
+        for(int z = aBegin; z < anEnd; z++)
+        {
+            for(int y = 0; y < side; y++)
+            {
+                for(int x = 0; x < side; x++)
+                {
+                    int count = 0;
+                    for(int dz = -1; dz <= 1; dz++)
+                    {
+                        for(int dy = -1; dy <= 1; dy++)
+                        {
+                            for(int dx = -1; dx <= 1; dx++)
+                                count += get((x + dx + side) % side, (y + dy + side) % side, (z + dz + side) % side);
+                        }
+                    }
+                    const bool isLive = get(x, y, z);
+                    if(isLive)
+                        count--;
+                    const bool isNext = isLive ? count >= myRule.surviveMin && count <= myRule.surviveMax
+                                               : count >= myRule.birthMin && count <= myRule.birthMax;
+                    if(isNext)
+                        next[((size_t)z * side + y) * myWordsPerRow + (x >> 6)] |= 1ULL << (x & 63);
+                }
+            }
+        }
+    });
+    myCells.swap(next);
+}
+
+/// <summary>
+/// Live cells of slice z in white, or how many cells each column along z holds, brighter for more
+/// </summary>
+static void drawCube(const Life3DGrid& aGrid, bool isProjected, int z, std::vector<uint16_t>& someCounts,
+                     std::vector<sf::Uint8>& outPixels)
+{
+    const int side = aGrid.getSide(), wordsPerRow = aGrid.getWordsPerRow();
+    std::fill(someCounts.begin(), someCounts.end(), 0);
+    const int firstZ = isProjected ? 0 : z, lastZ = isProjected ? side - 1 : z;
+    for(int planeZ = firstZ; planeZ <= lastZ; planeZ++)
+    {
+        for(int y = 0; y < side; y++)
+        {
+            const uint64_t* row = aGrid.getRow(y, planeZ);
+            uint16_t* counts = &someCounts[(size_t)y * side];
+            for(int i = 0; i < wordsPerRow; i++)
+            {
+                for(uint64_t word = row[i]; word; word &= word - 1)
+                    counts[64 * i + ctz64(word)]++;
+            }
+        }
+    }
+    const int maxCount = std::max(1, (int)*std::max_element(someCounts.begin(), someCounts.end()));
+    for(size_t i = 0; i < someCounts.size(); i++)
+    {
+        // A square root so a few cells deep still show next to the densest columns
+        const sf::Uint8 shade = someCounts[i] ? (sf::Uint8)(64 + 191 * std::sqrt((float)someCounts[i] / maxCount)) : 0;
+        outPixels[4 * i] = isProjected ? shade / 2 : shade;
+        outPixels[4 * i + 1] = shade;
+        outPixels[4 * i + 2] = shade;
+        outPixels[4 * i + 3] = 255;
+    }
+}
+
+int runLife3D(int argc, char* argv[])
+{
+    Life3DRule rule;
+    const bool isRuleRead = argc < 1 || parseLife3DRule(argv[0], rule);
+    const int side = argc > 1 ? atoi(argv[1]) : 128;
+    const float density = argc > 2 ? (float)atof(argv[2]) : kSeedDensity;
+    const unsigned numThreads = argc > 3 ? (unsigned)atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : 0;
+    if(!isRuleRead || side < 64 || 0 != side % 64)
+    {
+        LOG_INFO("usage: --life3d [rule like 4555 or 4-5/5] [side, a multiple of 64] [density] [threads] [seed]\n");
+        return 1;
+    }
+    Life3DGrid grid(side, rule, numThreads);
+    const int extent = std::max(1, (int)(kSeedExtent * side));
+    grid.seed(density, extent, seed);
+
+    sf::RenderWindow window(sf::VideoMode(kWindowSide, kWindowSide), "Life 3D");
+    window.setFramerateLimit(60);
+    sf::Texture texture;
+    texture.create(side, side);
+    std::vector<sf::Uint8> pixels((size_t)4 * side * side);
+    std::vector<uint16_t> counts((size_t)side * side);
+    sf::Sprite sprite(texture);
+    sprite.setScale((float)kWindowSide / side, (float)kWindowSide / side);
+    bool isPaused = false, isProjected = false;
+    int sliceZ = side / 2;
+    uint64_t generation = 0;
+    int numSteps = 0;
+    sf::Clock reportClock;
+    while(window.isOpen())
+    {
+        sf::Event event;
+        while(window.pollEvent(event))
+        {
+            if(sf::Event::Closed == event.type || (sf::Event::KeyPressed == event.type && sf::Keyboard::Escape == event.key.code))
+                window.close();
+            if(sf::Event::KeyPressed != event.type)
+                continue;
+            switch(event.key.code)
+            {
+            case sf::Keyboard::Space:
+                isPaused = !isPaused;
+                break;
+            case sf::Keyboard::N:
+                grid.step();
+                ++generation;
+                break;
+            case sf::Keyboard::R:
+                grid.seed(density, extent, ++seed);
+                generation = 0;
+                break;
+            case sf::Keyboard::Tab:
+                isProjected = !isProjected;
+                break;
+            case sf::Keyboard::Up:
+                sliceZ = (sliceZ + (event.key.shift ? 10 : 1)) % side;
+                break;
+            case sf::Keyboard::Down:
+                sliceZ = (sliceZ + side - (event.key.shift ? 10 : 1)) % side;
+                break;
+            default:
+                break;
+            }
+        }
+        if(!isPaused)
+        {
+            grid.step();
+            ++generation;
+            ++numSteps;
+        }
+        drawCube(grid, isProjected, sliceZ, counts, pixels);
+        texture.update(pixels.data());
+        if(reportClock.getElapsedTime() > sf::seconds(0.5f))
+        {
+            char title[160];
+            char view[32];
+            if(isProjected)
+                snprintf(view, sizeof(view), "projection along z");
+            else
+                snprintf(view, sizeof(view), "slice z = %d", sliceZ);
+            snprintf(title, sizeof(title), "Life 3D %s, %s, generation %llu, %.1f gen/s, population %llu%s", getRuleName(rule).c_str(),
+                     view, (unsigned long long)generation,
+                     numSteps / reportClock.restart().asSeconds(), (unsigned long long)grid.getPopulation(), isPaused ? " (paused)" : "");
+            window.setTitle(title);
+            numSteps = 0;
+        }
+        window.clear();
+        window.draw(sprite);
+        window.display();
+    }
+    return 0;
+}
+
+int runLife3DBenchmark(int argc, char* argv[])
+{
+    Life3DRule rule;
+    const bool isRuleRead = argc < 1 || parseLife3DRule(argv[0], rule);
+    const int side = argc > 1 ? atoi(argv[1]) : 256;
+    const int generations = argc > 2 ? atoi(argv[2]) : 10;
+    const unsigned numThreads = argc > 3 ? (unsigned)atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    if(!isRuleRead || side < 64 || 0 != side % 64 || generations < 1)
+    {
+        LOG_INFO("usage: --life3d-bench [rule like 4555 or 4-5/5] [side, a multiple of 64] [generations] [threads]\n");
+        return 1;
+    }
+    Life3DGrid grid(side, rule, numThreads);
+    grid.seed(kSeedDensity, side / 2, 0);
+    LOG_INFO("%s on %dx%dx%d, population %llu, %u threads\n", getRuleName(rule).c_str(), side, side, side, (unsigned long long)grid.getPopulation(), numThreads);
+    const double seconds = timePerCall(generations, [&grid]() { grid.step(); });
+    const double numCells = (double)side * side * side;
+    LOG_INFO("%-24s %10.3f ms/gen %12.4g cells/s, population %llu\n", "bitsliced", seconds * 1e3, numCells / seconds,
+             (unsigned long long)grid.getPopulation());
+
+    // The naive count is 27 reads a cell, it is checked on a small cube
+    Life3DGrid sliced(kCheckSide, rule, numThreads), naive(kCheckSide, rule, numThreads);
+    sliced.seed(kSeedDensity, kCheckSide / 2, 1);
+    naive.seed(kSeedDensity, kCheckSide / 2, 1);
+    double slicedSeconds, naiveSeconds;
+    const bool isMatch = checkAgainstNaive(sliced, naive, kCheckGenerations, slicedSeconds, naiveSeconds);
+    LOG_INFO("%-24s %10.1fx faster than the naive count on %d^3, %d generations %s\n", "", naiveSeconds / slicedSeconds, kCheckSide,
+             kCheckGenerations, isMatch ? "match" : "MISMATCH");
+    return isMatch ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Totalistic rule over the 26 cells of the 3x3x3 cube around a cell, in Bays' notation E_l E_u F_l F_u
+/// </summary>
+struct Life3DRule
+{
+    // Inclusive neighbour counts for a live cell to stay and a dead one to be born, 4555 by default
+    int surviveMin = 4, surviveMax = 5;
+    int birthMin = 5, birthMax = 5;
+};
+
+/// <summary>
+/// Parse "4555" or "5766", the four counts split by commas, or the survive and birth ranges as "0-26/0-26"
+/// when a count is above 9
+/// </summary>
+/// <returns>If the text was such a rule</returns>
+bool parseLife3DRule(const std::string& aText, Life3DRule& outRule);
+
+/// <summary>
+/// 3D Life on a cubic torus of 64-bit words along x, a 512 side is 16 MB a generation.
+/// Neighbours are counted 64 cells at a time in bitsliced adders: three cells along each row, then the 3x3 sum
+/// of each plane, kept for the three output planes that read it, then the sum of three planes. The cube is split
+/// into slabs of planes along z, one per thread.
+/// </summary>
+class Life3DGrid
+{
+public:
+    /// <summary>
+    /// Side a multiple of 64, so rows wrap on word boundaries
+    /// </summary>
+    Life3DGrid(int aSide, const Life3DRule& aRule, unsigned aNumThreads);
+
+    int getSide() const { return mySide; }
+    int getWordsPerRow() const { return myWordsPerRow; }
+    const Life3DRule& getRule() const { return myRule; }
+    const std::vector<uint64_t>& getCells() const { return myCells; }
+    const uint64_t* getRow(int y, int z) const { return &myCells[((size_t)z * mySide + y) * myWordsPerRow]; }
+
+    void clear();
+    bool get(int x, int y, int z) const { return (getRow(y, z)[x >> 6] >> (x & 63)) & 1; }
+    void set(int x, int y, int z, bool isLive);
+    uint64_t getPopulation() const;
+
+    /// <summary>
+    /// Random cells of a density in a cube around the centre, aExtent cells across, the rest empty
+    /// </summary>
+    void seed(float aDensity, int anExtent, uint64_t aSeed);
+
+    void step();
+    /// <summary>
+    /// One generation counting the 26 neighbours cell by cell, the reference for step
+    /// </summary>
+    void stepNaive();
+
+private:
+    /// <summary>
+    /// 3x3 sums of every cell of plane z in 4 slices a word, slice k the bit of weight 2^k
+    /// </summary>
+    void sumPlane(int z, uint64_t* outSums, std::vector<uint64_t>& someRowSums) const;
+
+    int mySide, myWordsPerRow;
+    Life3DRule myRule;
+    unsigned myNumThreads;
+    std::vector<uint64_t> myCells, myNextCells;
+};
+
+/// <summary>
+/// Command line entry, "--life3d [rule] [side] [density] [threads] [seed]". Opens a window on a z slice of the
+/// cube or its projection along z. Space pauses, N steps, R reseeds, Tab swaps slice and projection and the
+/// up and down arrows move the slice.
+/// </summary>
+int runLife3D(int argc, char* argv[]);
+
+/// <summary>
+/// Command line entry, "--life3d-bench [rule] [side] [generations] [threads]". Times the bitsliced step
+/// and checks it against the naive count on a smaller cube.
+/// </summary>
+int runLife3DBenchmark(int argc, char* argv[]);
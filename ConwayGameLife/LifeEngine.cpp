@@ -0,0 +1,238 @@
+#include "LifeEngine.h"
+#include <algorithm>
+#include "BitGrid.h"
+#include "BitOps.h"
+#include "Changes.h"
+#include "HashLife.h"
+#include "LifeStats.h"
+#include "TileSet.h"
+
+/// <summary>
+/// processCore behind the engine face, tiles are kept centred on the origin like the editor does
+/// </summary>
+class SparseSetEngine : public LifeEngine
+{
+public:
+    explicit SparseSetEngine(int aSide) : myHalfSide(aSide / 2) {}
+
+    EngineType getType() const override { return EngineType::SparseSet; }
+    int getSide() const override { return 2 * myHalfSide; }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        myLiveTiles.clear();
+        for(auto& cell : someCells)
+            myLiveTiles.insert(cell - sf::Vector2i(myHalfSide, myHalfSide));
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        outCells.clear();
+        for(auto& tile : myLiveTiles)
+            outCells.push_back(tile + sf::Vector2i(myHalfSide, myHalfSide));
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+            processCore(myLastLiveTiles, myLiveTiles, nullptr, myHalfSide);
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        outStats.reset();
+        outStats.population = myLiveTiles.size();
+        for(auto& tile : myLiveTiles)
+            outStats.include(tile.x + myHalfSide, tile.y + myHalfSide);
+    }
+
+private:
+    int myHalfSide;
+    TileSet myLiveTiles, myLastLiveTiles;
+};
+
+class DenseBitsEngine : public LifeEngine
+{
+public:
+    explicit DenseBitsEngine(int aSide) : myGrid(aSide, aSide)
+    {
+        myGrid.setSleeping(true);
+    }
+
+    EngineType getType() const override { return EngineType::DenseBits; }
+    int getSide() const override { return myGrid.getWidth(); }
+
+    void load(const std::vector<sf::Vector2i>& someCells) override
+    {
+        myGrid.clear();
+        for(auto& cell : someCells)
+            myGrid.set(cell.x, cell.y, true);
+    }
+
+    void save(std::vector<sf::Vector2i>& outCells) const override
+    {
+        saveWords(myGrid.getRow(0), myGrid.getWordsPerRow(), myGrid.getHeight(), outCells);
+    }
+
+    void step(uint64_t aGenerations) override
+    {
+        for(uint64_t i = 0; i < aGenerations; i++)
+            myGrid.step();
+    }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        sampleWords(myGrid.getRow(0), myGrid.getWordsPerRow(), myGrid.getHeight(), outStats);
+    }
+
+    bool getChanges(ChangeList& outChanges) const override { return myGrid.getChanges(outChanges); }
+
+private:
+    BitGrid myGrid;
+};
+
+class QuadTreeEngine : public LifeEngine
+{
+public:
+    explicit QuadTreeEngine(int aSide) : myTree(msb64((uint64_t)aSide)) {}
+
+    EngineType getType() const override { return EngineType::QuadTree; }
+    int getSide() const override { return myTree.getSide(); }
+    void load(const std::vector<sf::Vector2i>& someCells) override { myTree.load(someCells); }
+    void save(std::vector<sf::Vector2i>& outCells) const override { myTree.save(outCells); }
+    void step(uint64_t aGenerations) override { myTree.step(aGenerations); }
+
+    void sample(GenerationStats& outStats) const override
+    {
+        outStats.reset();
+        outStats.population = myTree.getPopulation();
+        myTree.getBoundingBox(outStats);
+    }
+
+private:
+    HashLife myTree;
+};
+
+void saveWords(const uint64_t* someCells, int aWordsPerRow, int aHeight, std::vector<sf::Vector2i>& outCells)
+{
+    outCells.clear();
+    for(int y = 0; y < aHeight; y++)
+    {
+        const uint64_t* row = someCells + (size_t)y * aWordsPerRow;
+        for(int i = 0; i < aWordsPerRow; i++)
+        {
+            for(uint64_t word = row[i]; word; word &= word - 1)
+                outCells.push_back(sf::Vector2i(i * 64 + ctz64(word), y));
+        }
+    }
+}
+
+void sampleWords(const uint64_t* someCells, int aWordsPerRow, int aHeight, GenerationStats& outStats)
+{
+    outStats.reset();
+    for(int y = 0; y < aHeight; y++)
+    {
+        const uint64_t* row = someCells + (size_t)y * aWordsPerRow;
+        for(int i = 0; i < aWordsPerRow; i++)
+        {
+            if(!row[i])
+                continue;
+            outStats.population += popcount64(row[i]);
+            outStats.includeBox(i * 64 + ctz64(row[i]), y, i * 64 + msb64(row[i]), y);
+        }
+    }
+}
+
+/// <summary>
+/// Reorder cells found row by row into column order, a counting sort by column that keeps rows ascending
+/// within each column, linear in the cells and the width
+/// </summary>
+static void orderByColumn(std::vector<sf::Vector2i>& ioCells, int aWidth, std::vector<uint32_t>& someStarts,
+                          std::vector<sf::Vector2i>& someScratch)
+{
+    if(ioCells.size() < 2)
+        return;
+    someStarts.assign((size_t)aWidth + 1, 0);
+    for(auto& cell : ioCells)
+        someStarts[cell.x + 1]++;
+    for(int x = 0; x < aWidth; x++)
+        someStarts[x + 1] += someStarts[x];
+    someScratch.resize(ioCells.size());
+    for(auto& cell : ioCells)
+        someScratch[someStarts[cell.x]++] = cell;
+    ioCells.swap(someScratch);
+}
+
+void collectChanges(const uint64_t* someCells, const uint64_t* somePreviousCells, int aWordsPerRow, int aHeight, ChangeList& outChanges)
+{
+    outChanges.clear();
+    for(int y = 0; y < aHeight; y++)
+    {
+        const uint64_t* current = someCells + (size_t)y * aWordsPerRow;
+        const uint64_t* previous = somePreviousCells + (size_t)y * aWordsPerRow;
+        for(int i = 0; i < aWordsPerRow; i++)
+        {
+            if(current[i] == previous[i])
+                continue;
+            for(uint64_t born = current[i] & ~previous[i]; born; born &= born - 1)
+                outChanges.births.push_back(sf::Vector2i(i * 64 + ctz64(born), y));
+            for(uint64_t died = previous[i] & ~current[i]; died; died &= died - 1)
+                outChanges.deaths.push_back(sf::Vector2i(i * 64 + ctz64(died), y));
+        }
+    }
+    static thread_local std::vector<uint32_t> ourStarts;
+    static thread_local std::vector<sf::Vector2i> ourScratch;
+    orderByColumn(outChanges.births, aWordsPerRow * 64, ourStarts, ourScratch);
+    orderByColumn(outChanges.deaths, aWordsPerRow * 64, ourStarts, ourScratch);
+}
+
+bool LifeEngine::getChanges(ChangeList& outChanges) const
+{
+    outChanges.clear();
+    return false;
+}
+
+const char* getEngineName(EngineType aType)
+{
+    switch(aType)
+    {
+    case SparseSet:
+        return "sparse set";
+    case DenseBits:
+        return "dense bits";
+    case QuadTree:
+        return "quadtree";
+    default:
+        return "unknown";
+    }
+}
+
+bool isEngineSupported(EngineType aType, int aSide)
+{
+    switch(aType)
+    {
+    case SparseSet:
+        return aSide >= 2 && 0 == aSide % 2;
+    case DenseBits:
+        return aSide >= 1;
+    case QuadTree:
+        return aSide >= 4 && 0 == (aSide & (aSide - 1));
+    default:
+        return false;
+    }
+}
+
+std::unique_ptr<LifeEngine> createEngine(EngineType aType, int aSide)
+{
+    switch(aType)
+    {
+    case SparseSet:
+        return std::unique_ptr<LifeEngine>(new SparseSetEngine(aSide));
+    case DenseBits:
+        return std::unique_ptr<LifeEngine>(new DenseBitsEngine(aSide));
+    case QuadTree:
+        return std::unique_ptr<LifeEngine>(new QuadTreeEngine(aSide));
+    default:
+        return nullptr;
+    }
+}
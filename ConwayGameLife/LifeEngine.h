@@ -0,0 +1,60 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct ChangeList;
+struct GenerationStats;
+
+enum EngineType
+{
+    SparseSet, // TileSet and processCore, cost follows the population
+    DenseBits, // BitGrid, cost follows the board area
+    QuadTree // HashLife, cost follows how regular the pattern is
+};
+
+/// <summary>
+/// Common face of the step engines so a board can move between them.
+/// All engines run B3/S23 on a square torus with cells from (0, 0) to (side - 1, side - 1).
+/// </summary>
+class LifeEngine
+{
+public:
+    virtual ~LifeEngine() {}
+
+    virtual EngineType getType() const = 0;
+    virtual int getSide() const = 0;
+    virtual void load(const std::vector<sf::Vector2i>& someCells) = 0;
+    virtual void save(std::vector<sf::Vector2i>& outCells) const = 0;
+    virtual void step(uint64_t aGenerations) = 0;
+    /// <summary>
+    /// Population and bounding box of the current generation
+    /// </summary>
+    virtual void sample(GenerationStats& outStats) const = 0;
+    /// <summary>
+    /// Cells born and died in the last generation stepped, sorted like a TileSet
+    /// </summary>
+    /// <returns>False when the engine cannot tell, it keeps no previous generation or cells were loaded since.
+    /// The lists are left empty then.</returns>
+    virtual bool getChanges(ChangeList& outChanges) const;
+};
+
+const char* getEngineName(EngineType aType);
+
+/// <summary>
+/// If the engine can run a torus of this side, the sparse set needs an even side and the quadtree a power of two
+/// </summary>
+bool isEngineSupported(EngineType aType, int aSide);
+
+std::unique_ptr<LifeEngine> createEngine(EngineType aType, int aSide);
+
+/// <summary>
+/// Cells and stats of bit packed rows stored one after another, shared by the dense engines
+/// </summary>
+void saveWords(const uint64_t* someCells, int aWordsPerRow, int aHeight, std::vector<sf::Vector2i>& outCells);
+void sampleWords(const uint64_t* someCells, int aWordsPerRow, int aHeight, GenerationStats& outStats);
+/// <summary>
+/// Births and deaths between two such boards, each list in column then row order like processCore emits them
+/// </summary>
+void collectChanges(const uint64_t* someCells, const uint64_t* somePreviousCells, int aWordsPerRow, int aHeight, ChangeList& outChanges);
@@ -0,0 +1,79 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "LifeStats.h"
+
+#pragma pack(push, 1)
+struct StatsRecord
+{
+    uint64_t generation;
+    uint64_t population;
+    uint64_t births;
+    uint64_t deaths;
+    int32_t minX, minY, maxX, maxY;
+    uint32_t density[kNumDensityBins];
+};
+#pragma pack(pop)
+
+static const char kStatsMagic[8] = { 'L', 'I', 'F', 'E', 'S', 'T', 'A', 'T' };
+
+StatsStream::~StatsStream()
+{
+    close();
+}
+
+bool StatsStream::open(const std::string& aPath)
+{
+    close();
+    myIsCsv = aPath.size() >= 4 && 0 == aPath.compare(aPath.size() - 4, 4, ".csv");
+    myFile = fopen(aPath.c_str(), myIsCsv ? "w" : "wb");
+    if(nullptr == myFile)
+        return false;
+    if(myIsCsv)
+    {
+        fprintf(myFile, "generation,population,births,deaths,minX,minY,maxX,maxY");
+        for(int i = 0; i < kNumDensityBins; i++)
+            fprintf(myFile, ",blocks%dto%d", 8 * i + 1, 8 * i + 8);
+        fprintf(myFile, "\n");
+    }
+    else
+        fwrite(kStatsMagic, sizeof(kStatsMagic), 1, myFile);
+    return true;
+}
+
+void StatsStream::close()
+{
+    if(nullptr != myFile)
+    {
+        fclose(myFile);
+        myFile = nullptr;
+    }
+}
+
+void StatsStream::write(const GenerationStats& aStats)
+{
+    if(nullptr == myFile)
+        return;
+    if(myIsCsv)
+    {
+        fprintf(myFile, "%llu,%llu,%llu,%llu,%d,%d,%d,%d",
+                (unsigned long long)aStats.generation, (unsigned long long)aStats.population,
+                (unsigned long long)aStats.births, (unsigned long long)aStats.deaths,
+                aStats.minX, aStats.minY, aStats.maxX, aStats.maxY);
+        for(int i = 0; i < kNumDensityBins; i++)
+            fprintf(myFile, ",%u", aStats.density[i]);
+        fprintf(myFile, "\n");
+    }
+    else
+    {
+        StatsRecord record = {};
+        record.generation = aStats.generation;
+        record.population = aStats.population;
+        record.births = aStats.births;
+        record.deaths = aStats.deaths;
+        record.minX = aStats.minX;
+        record.minY = aStats.minY;
+        record.maxX = aStats.maxX;
+        record.maxY = aStats.maxY;
+        std::copy(aStats.density, aStats.density + kNumDensityBins, record.density);
+        fwrite(&record, sizeof(record), 1, myFile);
+    }
+}
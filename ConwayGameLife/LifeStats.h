@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// The density histogram counts blocks of 2^kDensityLevel x 2^kDensityLevel cells by how many of their 64 cells live,
+// bin i holding blocks of 8i + 1 to 8i + 8 live cells. Empty blocks are not counted.
+static const int kDensityLevel = 3;
+static const int kNumDensityBins = 8;
+
+/// <summary>
+/// Statistics produced as a by-product of one generation step
+/// </summary>
+struct GenerationStats
+{
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+    // Inclusive bounding box of the live tiles, min > max when empty
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    // Filled from the population pyramid, which keeps it up to date with every birth and death
+    uint32_t density[kNumDensityBins] = {};
+
+    /// <summary>
+    /// Clear everything but the generation number
+    /// </summary>
+    void reset()
+    {
+        population = births = deaths = 0;
+        minX = minY = 0;
+        maxX = maxY = -1;
+        std::fill(density, density + kNumDensityBins, 0);
+    }
+
+    /// <summary>
+    /// Grow the bounding box to contain a rectangle
+    /// </summary>
+    void includeBox(int aMinX, int aMinY, int aMaxX, int aMaxY)
+    {
+        if(maxX < minX)
+        {
+            minX = aMinX; minY = aMinY; maxX = aMaxX; maxY = aMaxY;
+            return;
+        }
+        if(aMinX < minX) minX = aMinX;
+        if(aMinY < minY) minY = aMinY;
+        if(aMaxX > maxX) maxX = aMaxX;
+        if(aMaxY > maxY) maxY = aMaxY;
+    }
+
+    void include(int x, int y)
+    {
+        includeBox(x, y, x, y);
+    }
+};
+
+/// <summary>
+/// Per generation statistics sink, so long runs can be charted without another pass over the tiles.
+/// A path ending with ".csv" writes text rows, anything else writes fixed size binary records
+/// after an 8 byte "LIFESTAT" magic (native endianness). Both end with the density histogram.
+/// </summary>
+class StatsStream
+{
+public:
+    StatsStream() = default;
+    StatsStream(const StatsStream&) = delete;
+    StatsStream& operator=(const StatsStream&) = delete;
+    ~StatsStream();
+
+    bool open(const std::string& aPath);
+    void close();
+    bool isOpen() const { return nullptr != myFile; }
+    void write(const GenerationStats& aStats);
+
+private:
+    FILE* myFile = nullptr;
+    bool myIsCsv = true;
+};
@@ -0,0 +1,376 @@
+#include "MapServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "BitOps.h"
+#include "Changes.h"
+#include "Log.h"
+#include "Pattern.h"
+#include "PngWriter.h"
+
+// Rendered tiles kept, about 4 KB each for a typical board
+static const size_t kCacheTiles = 4096;
+// Zoom levels past one pixel per cell, up to 8 pixels per cell
+static const int kMagnifyZoom = 3;
+static const size_t kMaxRequestBytes = 8192;
+static const float kRequestSeconds = 5.f;
+static const float kReportSeconds = 5.f;
+static const double kDefaultRate = 10.0;
+
+size_t MapServer::TileKeyHash::operator()(const TileKey& aKey) const
+{
+    return (size_t)mix64((uint64_t)aKey.z << 58 ^ (uint64_t)(uint32_t)aKey.x << 29 ^ (uint32_t)aKey.y);
+}
+
+MapServer::MapServer(int aSide, unsigned aNumWorkers)
+    : myGrid(aSide, aSide)
+    , myGeneration(0)
+    , myIsStopping(false)
+    , myNumRequests(0)
+    , myNumHits(0)
+    , myNumRenders(0)
+{
+    myGrid.setSleeping(true);
+    myChunksPerRow = myGrid.getWordsPerRow();
+    myChunkChanges.assign((size_t)myChunksPerRow * ((aSide + BitGrid::kTileRows - 1) / BitGrid::kTileRows), 0);
+    // Zoom 0 shows the whole side in one tile, every level halves what a tile covers
+    myMaxZoom = 0;
+    while((int64_t)kTilePixels << myMaxZoom < aSide)
+        ++myMaxZoom;
+    myMaxZoom += kMagnifyZoom;
+    myThreads.resize(std::max(1u, aNumWorkers));
+}
+
+MapServer::~MapServer()
+{
+    myIsStopping = true;
+    myQueueCondition.notify_all();
+    for(auto& thread : myThreads)
+    {
+        if(thread.joinable())
+            thread.join();
+    }
+}
+
+bool MapServer::open(unsigned short aPort)
+{
+    if(sf::Socket::Done != myListener.listen(aPort))
+        return false;
+    const size_t numWorkers = myThreads.size();
+    myThreads.clear();
+    myThreads.emplace_back(&MapServer::acceptLoop, this);
+    for(size_t i = 0; i < numWorkers; i++)
+        myThreads.emplace_back(&MapServer::workerLoop, this);
+    return true;
+}
+
+void MapServer::load(const std::vector<sf::Vector2i>& someCells)
+{
+    std::unique_lock<std::shared_mutex> lock(myGridMutex);
+    for(auto& cell : someCells)
+        myGrid.set(cell.x, cell.y, true);
+    std::fill(myChunkChanges.begin(), myChunkChanges.end(), myGeneration);
+}
+
+void MapServer::step()
+{
+    std::unique_lock<std::shared_mutex> lock(myGridMutex);
+    myGrid.step();
+    ++myGeneration;
+    if(!myGrid.getChanges(myChanges))
+    {
+        std::fill(myChunkChanges.begin(), myChunkChanges.end(), myGeneration);
+        return;
+    }
+    for(auto* list : { &myChanges.births, &myChanges.deaths })
+    {
+        for(auto& cell : *list)
+            myChunkChanges[(size_t)(cell.y / BitGrid::kTileRows) * myChunksPerRow + (cell.x >> 6)] = myGeneration;
+    }
+}
+
+void MapServer::report()
+{
+    const float seconds = myReportClock.restart().asSeconds();
+    const uint64_t numRequests = myNumRequests.exchange(0), numHits = myNumHits.exchange(0), numRenders = myNumRenders.exchange(0);
+    size_t numCached;
+    {
+        std::lock_guard<std::mutex> lock(myCacheMutex);
+        numCached = myCache.size();
+    }
+    uint64_t generation;
+    {
+        std::shared_lock<std::shared_mutex> lock(myGridMutex);
+        generation = myGeneration;
+    }
+    LOG_INFO("gen %llu: %.1f requests/s, %llu cache hits, %llu renders, %d tiles cached\n", (unsigned long long)generation,
+             numRequests / seconds, (unsigned long long)numHits, (unsigned long long)numRenders, (int)numCached);
+}
+
+void MapServer::acceptLoop()
+{
+    sf::SocketSelector selector;
+    selector.add(myListener);
+    while(!myIsStopping)
+    {
+        // Wake now and then to notice the server stopping
+        if(!selector.wait(sf::milliseconds(200)))
+            continue;
+        auto socket = std::make_unique<sf::TcpSocket>();
+        if(sf::Socket::Done != myListener.accept(*socket))
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(myQueueMutex);
+            myConnections.push_back(std::move(socket));
+        }
+        myQueueCondition.notify_one();
+    }
+}
+
+void MapServer::workerLoop()
+{
+    for(;;)
+    {
+        std::unique_ptr<sf::TcpSocket> socket;
+        {
+            std::unique_lock<std::mutex> lock(myQueueMutex);
+            myQueueCondition.wait(lock, [this]() { return myIsStopping || !myConnections.empty(); });
+            if(myIsStopping)
+                return;
+            socket = std::move(myConnections.front());
+            myConnections.pop_front();
+        }
+        serve(*socket);
+        socket->disconnect();
+    }
+}
+
+/// <summary>
+/// Whole response, closing the connection after it
+/// </summary>
+static void respond(sf::TcpSocket& aSocket, const char* aStatus, const char* aType, const void* aBody, size_t aSize)
+{
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %llu\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n",
+                          aStatus, aType, (unsigned long long)aSize);
+    if(sf::Socket::Done == aSocket.send(header, length) && aSize)
+        aSocket.send(aBody, aSize);
+}
+
+// Leaflet from its CDN, the map is not a geographic one so it uses plain pixel coordinates
+static const char* kPage =
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Conway's Game of Life</title>"
+    "<link rel=\"stylesheet\" href=\"https://unpkg.com/leaflet@1.9.4/dist/leaflet.css\"/>"
+    "<script src=\"https://unpkg.com/leaflet@1.9.4/dist/leaflet.js\"></script>"
+    "<style>html,body,#map{height:100%%;margin:0;background:#000}</style></head><body><div id=\"map\"></div><script>"
+    "var map=L.map('map',{crs:L.CRS.Simple,minZoom:0,maxZoom:%d}).setView([-128,128],1);"
+    "var layer=L.tileLayer('/{z}/{x}/{y}.png?t='+Date.now(),{tileSize:256,noWrap:true,maxZoom:%d,"
+    "bounds:[[-256,0],[0,256]]}).addTo(map);"
+    "setInterval(function(){layer.setUrl('/{z}/{x}/{y}.png?t='+Date.now());},1000);"
+    "</script></body></html>";
+
+void MapServer::serve(sf::TcpSocket& aSocket)
+{
+    // Read up to the end of the headers, giving up on clients that stay silent
+    std::string request;
+    sf::SocketSelector selector;
+    selector.add(aSocket);
+    while(std::string::npos == request.find("\r\n\r\n") && request.size() < kMaxRequestBytes)
+    {
+        char buffer[1024];
+        size_t received;
+        if(!selector.wait(sf::seconds(kRequestSeconds)) || sf::Socket::Done != aSocket.receive(buffer, sizeof(buffer), received))
+            return;
+        request.append(buffer, received);
+    }
+    ++myNumRequests;
+    char method[8], path[256];
+    if(2 != sscanf(request.c_str(), "%7s %255s", method, path) || std::string("GET") != method)
+    {
+        respond(aSocket, "405 Method Not Allowed", "text/plain", "", 0);
+        return;
+    }
+    if(std::string("/") == path)
+    {
+        char page[2048];
+        int length = snprintf(page, sizeof(page), kPage, myMaxZoom, myMaxZoom);
+        respond(aSocket, "200 OK", "text/html", page, length);
+        return;
+    }
+    TileKey key;
+    char end = 0;
+    if(4 == sscanf(path, "/%d/%d/%d.pn%c", &key.z, &key.x, &key.y, &end) && 'g' == end
+       && key.z >= 0 && key.z <= myMaxZoom && key.x >= 0 && key.y >= 0 && key.x < (1 << key.z) && key.y < (1 << key.z))
+    {
+        Png png = getTile(key);
+        respond(aSocket, "200 OK", "image/png", png->data(), png->size());
+        return;
+    }
+    respond(aSocket, "404 Not Found", "text/plain", "", 0);
+}
+
+MapServer::Png MapServer::getTile(const TileKey& aKey)
+{
+    std::vector<uint8_t> pixels;
+    uint64_t generation;
+    {
+        std::shared_lock<std::shared_mutex> lock(myGridMutex);
+        generation = myGeneration;
+        const uint64_t lastChange = getLastChange(aKey);
+        {
+            std::lock_guard<std::mutex> cacheLock(myCacheMutex);
+            auto it = myCache.find(aKey);
+            if(myCache.end() != it && it->second.generation >= lastChange)
+            {
+                myLru.splice(myLru.begin(), myLru, it->second.lruPosition);
+                ++myNumHits;
+                return it->second.png;
+            }
+        }
+        render(aKey, pixels);
+    }
+    // Encoding needs only the pixels, the board is free to step meanwhile
+    auto png = std::make_shared<std::vector<uint8_t>>();
+    encodePng(pixels.data(), kTilePixels, kTilePixels, 1, *png);
+    ++myNumRenders;
+    std::lock_guard<std::mutex> cacheLock(myCacheMutex);
+    auto it = myCache.find(aKey);
+    if(myCache.end() != it)
+    {
+        // Another worker may have stored a newer one meanwhile
+        if(it->second.generation < generation)
+        {
+            it->second.generation = generation;
+            it->second.png = png;
+        }
+        myLru.splice(myLru.begin(), myLru, it->second.lruPosition);
+        return png;
+    }
+    if(myCache.size() >= kCacheTiles)
+    {
+        myCache.erase(myLru.back());
+        myLru.pop_back();
+    }
+    myLru.push_front(aKey);
+    myCache.emplace(aKey, CachedTile{ generation, png, myLru.begin() });
+    return png;
+}
+
+/// <summary>
+/// First cell of each pixel along one axis of a tile, kTilePixels + 1 bounds. Zoomed in past one cell a pixel
+/// the bounds repeat, every pixel still gets at least its own cell.
+/// </summary>
+static void getPixelBounds(int aZoom, int aTile, int aSide, std::vector<int>& outBounds)
+{
+    outBounds.resize(MapServer::kTilePixels + 1);
+    const int64_t denominator = (int64_t)MapServer::kTilePixels << aZoom;
+    for(int i = 0; i <= MapServer::kTilePixels; i++)
+        outBounds[i] = (int)(((int64_t)aTile * MapServer::kTilePixels + i) * aSide / denominator);
+}
+
+uint64_t MapServer::getLastChange(const TileKey& aKey) const
+{
+    std::vector<int> xs, ys;
+    getPixelBounds(aKey.z, aKey.x, myGrid.getWidth(), xs);
+    getPixelBounds(aKey.z, aKey.y, myGrid.getHeight(), ys);
+    const int firstX = xs.front() >> 6, lastX = (std::max(xs.back(), xs.front() + 1) - 1) >> 6;
+    const int firstY = ys.front() / BitGrid::kTileRows, lastY = (std::max(ys.back(), ys.front() + 1) - 1) / BitGrid::kTileRows;
+    uint64_t result = 0;
+    for(int y = firstY; y <= lastY; y++)
+    {
+        for(int x = firstX; x <= lastX; x++)
+            result = std::max(result, myChunkChanges[(size_t)y * myChunksPerRow + x]);
+    }
+    return result;
+}
+
+void MapServer::render(const TileKey& aKey, std::vector<uint8_t>& outPixels) const
+{
+    std::vector<int> xs, ys;
+    getPixelBounds(aKey.z, aKey.x, myGrid.getWidth(), xs);
+    getPixelBounds(aKey.z, aKey.y, myGrid.getHeight(), ys);
+    outPixels.assign((size_t)kTilePixels * kTilePixels, 0);
+    std::vector<uint64_t> rowCounts(kTilePixels);
+    for(int py = 0; py < kTilePixels; py++)
+    {
+        const int y0 = ys[py], y1 = std::max(ys[py + 1], y0 + 1);
+        std::fill(rowCounts.begin(), rowCounts.end(), 0);
+        for(int y = y0; y < y1; y++)
+        {
+            const uint64_t* row = myGrid.getRow(y);
+            for(int px = 0; px < kTilePixels; px++)
+            {
+                const int x0 = xs[px], x1 = std::max(xs[px + 1], x0 + 1);
+                // Bits x0 to x1 - 1, a word at a time
+                for(int word = x0 >> 6; word <= (x1 - 1) >> 6; word++)
+                {
+                    uint64_t bits = row[word];
+                    if(word == x0 >> 6)
+                        bits &= ~0ULL << (x0 & 63);
+                    if(word == (x1 - 1) >> 6 && (x1 & 63))
+                        bits &= ~(~0ULL << (x1 & 63));
+                    rowCounts[px] += popcount64(bits);
+                }
+            }
+        }
+        for(int px = 0; px < kTilePixels; px++)
+        {
+            const double area = (double)(std::max(xs[px + 1], xs[px] + 1) - xs[px]) * (y1 - y0);
+            // Shaded by density like the zoomed out window, any life at all stays visible
+            if(rowCounts[px])
+                outPixels[(size_t)py * kTilePixels + px] = (uint8_t)(64 + 191 * std::min(1.0, rowCounts[px] / area));
+        }
+    }
+}
+
+int runMapServer(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        LOG_INFO("usage: --map <port> <side> <pattern.rle | density> [generations per second] [threads] [seed]\n");
+        return 1;
+    }
+    const unsigned short port = (unsigned short)atoi(argv[0]);
+    const int side = std::max(2, atoi(argv[1]));
+    const double rate = argc > 3 ? atof(argv[3]) : kDefaultRate;
+    const unsigned numThreads = argc > 4 ? (unsigned)atoi(argv[4]) : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<sf::Vector2i> cells;
+    makeBoard(argv[2], side, argc > 5 ? strtoull(argv[5], nullptr, 10) : 0, cells);
+    MapServer server(side, numThreads);
+    server.load(cells);
+    if(!server.open(port))
+    {
+        LOG_ERROR("failed to listen on port %d\n", (int)port);
+        return 1;
+    }
+    LOG_INFO("serving %dx%d at http://localhost:%d/, tiles at /z/x/y.png up to zoom %d, %u workers\n",
+             side, side, (int)port, server.getMaxZoom(), numThreads);
+    sf::Clock clock, reportClock;
+    sf::Time nextStep = sf::Time::Zero;
+    for(;;)
+    {
+        if(rate <= 0.0)
+        {
+            // Paused, the board only serves
+            sf::sleep(sf::seconds(kReportSeconds));
+        }
+        else
+        {
+            sf::Time wait = nextStep - clock.getElapsedTime();
+            if(wait > sf::Time::Zero)
+                sf::sleep(wait);
+            nextStep += sf::seconds((float)(1.0 / rate));
+            if(nextStep < clock.getElapsedTime())
+                nextStep = clock.getElapsedTime();
+            server.step();
+        }
+        if(reportClock.getElapsedTime().asSeconds() >= kReportSeconds)
+        {
+            reportClock.restart();
+            server.report();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BitGrid.h"
+#include "Changes.h"
+
+/// <summary>
+/// Minimal HTTP server of 256x256 PNG map tiles of a running board, "/z/x/y.png" in the usual slippy map layout
+/// with the whole torus in the one tile of zoom 0, and a browser page at "/".
+/// Requests are read, rendered and encoded on a pool of workers while the board keeps stepping. Rendered tiles stay
+/// in an LRU cache and are served for later generations until a 64x64 chunk under them changes.
+/// </summary>
+class MapServer
+{
+public:
+    static const int kTilePixels = 256;
+
+    /// <param name="aSide">Side of the torus, stepped by the caller through step</param>
+    MapServer(int aSide, unsigned aNumWorkers);
+    MapServer(const MapServer&) = delete;
+    MapServer& operator=(const MapServer&) = delete;
+    ~MapServer();
+
+    /// <summary>
+    /// Start listening and serving
+    /// </summary>
+    bool open(unsigned short aPort);
+
+    /// <summary>
+    /// Set cells before the first step, from (0, 0) to (side - 1, side - 1)
+    /// </summary>
+    void load(const std::vector<sf::Vector2i>& someCells);
+    /// <summary>
+    /// Advance a generation, tile requests wait while the board is written
+    /// </summary>
+    void step();
+
+    /// <summary>
+    /// Log the requests served and the cache use since the last report
+    /// </summary>
+    void report();
+
+    /// <summary>
+    /// Deepest zoom, a cell is 8 pixels wide there
+    /// </summary>
+    int getMaxZoom() const { return myMaxZoom; }
+
+private:
+    typedef std::shared_ptr<const std::vector<uint8_t>> Png;
+
+    struct TileKey
+    {
+        int z, x, y;
+        bool operator==(const TileKey& anOther) const { return z == anOther.z && x == anOther.x && y == anOther.y; }
+    };
+
+    struct TileKeyHash
+    {
+        size_t operator()(const TileKey& aKey) const;
+    };
+
+    struct CachedTile
+    {
+        // Generation the tile shows, still right for later ones while its chunks stay unchanged
+        uint64_t generation;
+        Png png;
+        std::list<TileKey>::iterator lruPosition;
+    };
+
+    void acceptLoop();
+    void workerLoop();
+    void serve(sf::TcpSocket& aSocket);
+    Png getTile(const TileKey& aKey);
+    void render(const TileKey& aKey, std::vector<uint8_t>& outPixels) const;
+    uint64_t getLastChange(const TileKey& aKey) const;
+
+    BitGrid myGrid;
+    uint64_t myGeneration;
+    ChangeList myChanges;
+    // Generation each 64x64 chunk last changed in, one chunk per word column and BitGrid::kTileRows rows
+    std::vector<uint64_t> myChunkChanges;
+    int myChunksPerRow;
+    int myMaxZoom;
+    // Held shared while rendering and exclusively while stepping
+    mutable std::shared_mutex myGridMutex;
+
+    std::mutex myCacheMutex;
+    std::list<TileKey> myLru;
+    std::unordered_map<TileKey, CachedTile, TileKeyHash> myCache;
+
+    sf::TcpListener myListener;
+    std::mutex myQueueMutex;
+    std::condition_variable myQueueCondition;
+    std::deque<std::unique_ptr<sf::TcpSocket>> myConnections;
+    std::atomic<bool> myIsStopping;
+    std::vector<std::thread> myThreads;
+
+    std::atomic<uint64_t> myNumRequests, myNumHits, myNumRenders;
+    sf::Clock myReportClock;
+};
+
+/// <summary>
+/// Command line entry, "--map <port> <side> <pattern.rle | density> [generations per second] [threads] [seed]"
+/// </summary>
+int runMapServer(int argc, char* argv[]);
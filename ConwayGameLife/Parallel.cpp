@@ -0,0 +1,105 @@
+#include "Parallel.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Set on pool threads and on a caller while it runs strips, whose own runOnWorkers calls then run inline
+static thread_local bool ourIsInStrip = false;
+
+/// <summary>
+/// Threads kept waiting between calls, so a step doesn't pay for creating and joining them every time
+/// </summary>
+class WorkerPool
+{
+public:
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(myMutex);
+            myIsStopping = true;
+        }
+        myJobCondition.notify_all();
+        for(auto& thread : myThreads)
+            thread.join();
+    }
+
+    void run(int aNumStrips, const std::function<void(int)>& aStrip)
+    {
+        // One job at a time, the others wait for it
+        std::lock_guard<std::mutex> runLock(myRunMutex);
+        {
+            std::lock_guard<std::mutex> lock(myMutex);
+            while((int)myThreads.size() < aNumStrips - 1)
+                myThreads.emplace_back(&WorkerPool::work, this);
+            myJob = &aStrip;
+            myNumStrips = aNumStrips;
+            myNextStrip = 0;
+            myNumDone = 0;
+            ++myJobId;
+        }
+        myJobCondition.notify_all();
+        ourIsInStrip = true;
+        runJobStrips();
+        ourIsInStrip = false;
+        std::unique_lock<std::mutex> lock(myMutex);
+        myDoneCondition.wait(lock, [this]() { return myNumDone == myNumStrips; });
+        myJob = nullptr;
+    }
+
+private:
+    /// <summary>
+    /// Take strips of the current job until none are left
+    /// </summary>
+    void runJobStrips()
+    {
+        std::unique_lock<std::mutex> lock(myMutex);
+        while(myJob && myNextStrip < myNumStrips)
+        {
+            const int strip = myNextStrip++;
+            const std::function<void(int)>& job = *myJob;
+            lock.unlock();
+            job(strip);
+            lock.lock();
+            if(++myNumDone == myNumStrips)
+                myDoneCondition.notify_one();
+        }
+    }
+
+    void work()
+    {
+        ourIsInStrip = true;
+        uint64_t seenJobId = 0;
+        for(;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(myMutex);
+                myJobCondition.wait(lock, [this, seenJobId]() { return myIsStopping || myJobId != seenJobId; });
+                if(myIsStopping)
+                    return;
+                seenJobId = myJobId;
+            }
+            runJobStrips();
+        }
+    }
+
+    std::mutex myRunMutex, myMutex;
+    std::condition_variable myJobCondition, myDoneCondition;
+    std::vector<std::thread> myThreads;
+    const std::function<void(int)>* myJob = nullptr;
+    int myNumStrips = 0, myNextStrip = 0, myNumDone = 0;
+    uint64_t myJobId = 0;
+    bool myIsStopping = false;
+};
+
+void runOnWorkers(int aNumStrips, const std::function<void(int)>& aStrip)
+{
+    if(aNumStrips <= 1 || ourIsInStrip)
+    {
+        for(int strip = 0; strip < aNumStrips; strip++)
+            aStrip(strip);
+        return;
+    }
+    static WorkerPool ourPool;
+    ourPool.run(aNumStrips, aStrip);
+}
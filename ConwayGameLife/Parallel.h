@@ -0,0 +1,28 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+/// <summary>
+/// Run aStrip(0) to aStrip(aNumStrips - 1) on the shared worker pool, the calling thread taking strips as well.
+/// The pool is started once and grows to the most strips ever asked for at once. Calls from inside a strip
+/// run on the calling thread alone, calls from other threads wait for the running job. Returns once every strip is done.
+/// </summary>
+void runOnWorkers(int aNumStrips, const std::function<void(int)>& aStrip);
+
+/// <summary>
+/// Split [0, aCount) into one contiguous range per thread and run aFunction(begin, end) on each
+/// through runOnWorkers. Returns once every range is done.
+/// </summary>
+template<typename F>
+static void runStrips(int aCount, unsigned aNumThreads, F aFunction)
+{
+    const int numStrips = std::max(1, std::min((int)aNumThreads, aCount));
+    auto stripBegin = [aCount, numStrips](int aStrip) { return (int)((int64_t)aCount * aStrip / numStrips); };
+    if(1 == numStrips)
+    {
+        aFunction(0, aCount);
+        return;
+    }
+    runOnWorkers(numStrips, [&](int aStrip) { aFunction(stripBegin(aStrip), stripBegin(aStrip + 1)); });
+}
@@ -0,0 +1,136 @@
+#include "Pattern.h"
+#include <cctype>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+bool parseRle(const std::string& aText, std::vector<sf::Vector2i>& outCells)
+{
+    outCells.clear();
+    std::istringstream stream(aText);
+    std::string line, body;
+    bool hasHeader = false;
+    while(std::getline(stream, line))
+    {
+        if(line.empty() || '#' == line[0])
+            continue;
+        if(!hasHeader && std::string::npos != line.find('='))
+        {
+            hasHeader = true;
+            continue;
+        }
+        body += line;
+    }
+    int x = 0, y = 0, run = 0;
+    for(char c : body)
+    {
+        if(isdigit((unsigned char)c))
+        {
+            run = run * 10 + (c - '0');
+            continue;
+        }
+        int count = run ? run : 1;
+        run = 0;
+        switch(c)
+        {
+        case 'b':
+        case '.':
+            x += count;
+            break;
+        case '$':
+            y += count;
+            x = 0;
+            break;
+        case '!':
+            return true;
+        default:
+            if(isspace((unsigned char)c))
+                break;
+            // 'o' and any other state letter are live
+            for(int i = 0; i < count; i++)
+                outCells.push_back(sf::Vector2i(x++, y));
+            break;
+        }
+    }
+    return !outCells.empty();
+}
+
+bool readRle(const std::string& aPath, std::vector<sf::Vector2i>& outCells)
+{
+    std::ifstream file(aPath);
+    if(!file)
+        return false;
+    std::stringstream text;
+    text << file.rdbuf();
+    return parseRle(text.str(), outCells);
+}
+
+std::string writeRle(const std::vector<sf::Vector2i>& someCells)
+{
+    if(someCells.empty())
+        return "x = 0, y = 0\n!\n";
+    sf::Vector2i minimum = someCells[0], maximum = someCells[0];
+    for(auto& cell : someCells)
+    {
+        minimum = sf::Vector2i(std::min(minimum.x, cell.x), std::min(minimum.y, cell.y));
+        maximum = sf::Vector2i(std::max(maximum.x, cell.x), std::max(maximum.y, cell.y));
+    }
+    std::vector<sf::Vector2i> cells = someCells;
+    std::sort(cells.begin(), cells.end(), [](const sf::Vector2i& lhs, const sf::Vector2i& rhs)
+    {
+        return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+    });
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    std::string result = "x = " + std::to_string(maximum.x - minimum.x + 1) + ", y = " + std::to_string(maximum.y - minimum.y + 1) + "\n";
+    auto appendRun = [&result](int aCount, char aTag)
+    {
+        if(aCount > 1)
+            result += std::to_string(aCount);
+        if(aCount > 0)
+            result += aTag;
+    };
+    sf::Vector2i position = minimum;
+    for(size_t i = 0; i < cells.size();)
+    {
+        appendRun(cells[i].y - position.y, '$');
+        if(cells[i].y != position.y)
+            position = sf::Vector2i(minimum.x, cells[i].y);
+        appendRun(cells[i].x - position.x, 'b');
+        size_t end = i + 1;
+        while(end < cells.size() && cells[end].y == cells[i].y && cells[end].x == cells[end - 1].x + 1)
+            ++end;
+        appendRun((int)(end - i), 'o');
+        position.x = cells[end - 1].x + 1;
+        i = end;
+    }
+    return result + "!\n";
+}
+
+void makeBoard(const std::string& aSource, int aSide, uint64_t aSeed, std::vector<sf::Vector2i>& outCells)
+{
+    if(readRle(aSource, outCells))
+    {
+        sf::Vector2i size(0, 0);
+        for(auto& cell : outCells)
+            size = sf::Vector2i(std::max(size.x, cell.x + 1), std::max(size.y, cell.y + 1));
+        for(auto& cell : outCells)
+        {
+            cell.x = ((cell.x + (aSide - size.x) / 2) % aSide + aSide) % aSide;
+            cell.y = ((cell.y + (aSide - size.y) / 2) % aSide + aSide) % aSide;
+        }
+        return;
+    }
+    outCells.clear();
+    std::mt19937_64 random(aSeed);
+    std::bernoulli_distribution isLive(atof(aSource.c_str()));
+    for(int y = 0; y < aSide; y++)
+    {
+        for(int x = 0; x < aSide; x++)
+        {
+            if(isLive(random))
+                outCells.push_back(sf::Vector2i(x, y));
+        }
+    }
+}
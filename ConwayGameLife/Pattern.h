@@ -0,0 +1,25 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Parse run length encoded Life patterns ("x = 3, y = 3" header, b/o/$ runs ending with !).
+/// Cells start at (0, 0), comment lines and the rule are ignored.
+/// </summary>
+/// <returns>If the text held a pattern</returns>
+bool parseRle(const std::string& aText, std::vector<sf::Vector2i>& outCells);
+
+bool readRle(const std::string& aPath, std::vector<sf::Vector2i>& outCells);
+
+/// <summary>
+/// Run length encoded text of the cells, moved so the bounding box starts at (0, 0)
+/// </summary>
+std::string writeRle(const std::vector<sf::Vector2i>& someCells);
+
+/// <summary>
+/// Starting board of a square torus, cells from (0, 0) to (aSide - 1, aSide - 1)
+/// </summary>
+/// <param name="aSource">An RLE file, centred and wrapped where it does not fit, or else the density of a random soup</param>
+void makeBoard(const std::string& aSource, int aSide, uint64_t aSeed, std::vector<sf::Vector2i>& outCells);
@@ -0,0 +1,170 @@
+#include "PerfCounters.h"
+#include "Log.h"
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* kCounterNames[PerfCounters::NumCounters] = { "cycles", "instructions", "L1D misses", "LLC misses", "branch misses" };
+
+const char* PerfCounters::getName(Counter aCounter)
+{
+    return kCounterNames[aCounter];
+}
+
+PerfCounters::PerfCounters()
+{
+    for(int& file : myFiles)
+        file = -1;
+}
+
+bool PerfCounters::isAvailable() const
+{
+    for(int file : myFiles)
+    {
+        if(file >= 0)
+            return true;
+    }
+    return false;
+}
+
+#ifdef __linux__
+
+/// <summary>
+/// Type and config of each counter
+/// </summary>
+static void getEvent(PerfCounters::Counter aCounter, perf_event_attr& outAttributes)
+{
+    const uint64_t readMiss = (uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8 | (uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    switch(aCounter)
+    {
+    case PerfCounters::Cycles:
+        outAttributes.type = PERF_TYPE_HARDWARE;
+        outAttributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PerfCounters::Instructions:
+        outAttributes.type = PERF_TYPE_HARDWARE;
+        outAttributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PerfCounters::L1DMisses:
+        outAttributes.type = PERF_TYPE_HW_CACHE;
+        outAttributes.config = PERF_COUNT_HW_CACHE_L1D | readMiss;
+        break;
+    case PerfCounters::LLCMisses:
+        outAttributes.type = PERF_TYPE_HW_CACHE;
+        outAttributes.config = PERF_COUNT_HW_CACHE_LL | readMiss;
+        break;
+    default:
+        outAttributes.type = PERF_TYPE_HARDWARE;
+        outAttributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for(int file : myFiles)
+    {
+        if(file >= 0)
+            close(file);
+    }
+}
+
+bool PerfCounters::open()
+{
+    for(int i = 0; i < NumCounters; i++)
+    {
+        if(myFiles[i] >= 0)
+            continue;
+        perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        getEvent((Counter)i, attributes);
+        attributes.disabled = 1;
+        // User space only, which unprivileged processes may count at perf_event_paranoid 2
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        myFiles[i] = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        if(myFiles[i] < 0)
+            LOG_WARNING("%s counter unavailable: %s\n", kCounterNames[i], strerror(errno));
+    }
+    if(!isAvailable())
+        LOG_WARNING("no hardware counters, containers usually need perf_event_paranoid <= 2 and perf_event_open allowed by seccomp\n");
+    return isAvailable();
+}
+
+void PerfCounters::start()
+{
+    for(int file : myFiles)
+    {
+        if(file >= 0)
+            ioctl(file, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::stop()
+{
+    for(int file : myFiles)
+    {
+        if(file >= 0)
+            ioctl(file, PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void PerfCounters::reset()
+{
+    for(int file : myFiles)
+    {
+        if(file >= 0)
+            ioctl(file, PERF_EVENT_IOC_RESET, 0);
+    }
+}
+
+void PerfCounters::read(Sample& outSample) const
+{
+    for(int i = 0; i < NumCounters; i++)
+    {
+        // Value, time enabled and time running
+        uint64_t values[3];
+        outSample.isValid[i] = myFiles[i] >= 0 && sizeof(values) == ::read(myFiles[i], values, sizeof(values)) && values[2];
+        outSample.values[i] = 0;
+        if(outSample.isValid[i])
+            outSample.values[i] = values[2] < values[1] ? (uint64_t)((double)values[0] * values[1] / values[2]) : values[0];
+    }
+}
+
+#else
+
+PerfCounters::~PerfCounters()
+{
+}
+
+bool PerfCounters::open()
+{
+    LOG_WARNING("hardware counters are only read on Linux\n");
+    return false;
+}
+
+void PerfCounters::start()
+{
+}
+
+void PerfCounters::stop()
+{
+}
+
+void PerfCounters::reset()
+{
+}
+
+void PerfCounters::read(Sample& outSample) const
+{
+    outSample = Sample();
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Hardware counters of the calling thread, through perf_event_open on Linux. Counters the kernel or the
+/// container refuses are left out, and without any, or off Linux, the class does nothing and says so.
+/// </summary>
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        L1DMisses, // Level 1 data cache read misses
+        LLCMisses, // Last level cache read misses
+        BranchMisses,
+        NumCounters
+    };
+
+    struct Sample
+    {
+        uint64_t values[NumCounters] = {};
+        bool isValid[NumCounters] = {};
+    };
+
+    PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    /// <summary>
+    /// Open what the system allows, logging the counters that are missing and why
+    /// </summary>
+    /// <returns>If any counter works</returns>
+    bool open();
+    bool isAvailable() const;
+
+    /// <summary>
+    /// Count from here to stop, adding to the totals, around each call worth measuring
+    /// </summary>
+    void start();
+    void stop();
+    /// <summary>
+    /// Totals since the last reset, scaled up when the kernel had to share the hardware between counters
+    /// </summary>
+    void read(Sample& outSample) const;
+    void reset();
+
+    static const char* getName(Counter aCounter);
+
+private:
+    int myFiles[NumCounters];
+};
@@ -0,0 +1,241 @@
+#include "PngWriter.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+static const int kHashBits = 15;
+static const size_t kWindow = 32768;
+static const size_t kMinMatch = 3, kMaxMatch = 258;
+// Candidates followed along the hash chain, more finds longer matches and costs more
+static const int kMaxChainLength = 16;
+
+static const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+/// <summary>
+/// Deflate bit order, values from the least significant bit and Huffman codes from the most
+/// </summary>
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& ioBytes) : myBytes(ioBytes), myBits(0), myNumBits(0) {}
+
+    void write(uint32_t aValue, int aNumBits)
+    {
+        myBits |= (uint64_t)aValue << myNumBits;
+        myNumBits += aNumBits;
+        while(myNumBits >= 8)
+        {
+            myBytes.push_back((uint8_t)myBits);
+            myBits >>= 8;
+            myNumBits -= 8;
+        }
+    }
+
+    void writeCode(uint32_t aCode, int aNumBits)
+    {
+        uint32_t reversed = 0;
+        for(int i = 0; i < aNumBits; i++)
+            reversed |= ((aCode >> i) & 1) << (aNumBits - 1 - i);
+        write(reversed, aNumBits);
+    }
+
+    void finish()
+    {
+        if(myNumBits)
+            write(0, 8 - myNumBits);
+    }
+
+private:
+    std::vector<uint8_t>& myBytes;
+    uint64_t myBits;
+    int myNumBits;
+};
+
+static void writeLiteral(BitWriter& aWriter, int aSymbol)
+{
+    if(aSymbol < 144)
+        aWriter.writeCode(0x30 + aSymbol, 8);
+    else if(aSymbol < 256)
+        aWriter.writeCode(0x190 + aSymbol - 144, 9);
+    else if(aSymbol < 280)
+        aWriter.writeCode(aSymbol - 256, 7);
+    else
+        aWriter.writeCode(0xc0 + aSymbol - 280, 8);
+}
+
+static void writeMatch(BitWriter& aWriter, size_t aLength, size_t aDistance)
+{
+    int code = 28;
+    while(kLengthBase[code] > aLength)
+        --code;
+    writeLiteral(aWriter, 257 + code);
+    aWriter.write((uint32_t)(aLength - kLengthBase[code]), kLengthExtra[code]);
+    code = 29;
+    while(kDistanceBase[code] > aDistance)
+        --code;
+    aWriter.writeCode(code, 5);
+    aWriter.write((uint32_t)(aDistance - kDistanceBase[code]), kDistanceExtra[code]);
+}
+
+static uint32_t hash3(const uint8_t* aBytes)
+{
+    return ((uint32_t)aBytes[0] << 16 | (uint32_t)aBytes[1] << 8 | aBytes[2]) * 2654435761u >> (32 - kHashBits);
+}
+
+static uint32_t adler32(const uint8_t* someBytes, size_t aSize)
+{
+    uint32_t a = 1, b = 0;
+    while(aSize)
+    {
+        // Sums stay below 2^32 for this many bytes between reductions
+        size_t count = std::min<size_t>(aSize, 5552);
+        for(size_t i = 0; i < count; i++)
+        {
+            a += someBytes[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        someBytes += count;
+        aSize -= count;
+    }
+    return b << 16 | a;
+}
+
+void deflateZlib(const uint8_t* someBytes, size_t aSize, std::vector<uint8_t>& outBytes)
+{
+    outBytes.push_back(0x78);
+    outBytes.push_back(0x01);
+    BitWriter writer(outBytes);
+    // One final block with the fixed codes
+    writer.write(1, 1);
+    writer.write(1, 2);
+    std::vector<int32_t> heads((size_t)1 << kHashBits, -1);
+    std::vector<int32_t> previous(kWindow, -1);
+    auto insert = [&](size_t aPosition)
+    {
+        uint32_t hash = hash3(someBytes + aPosition);
+        previous[aPosition & (kWindow - 1)] = heads[hash];
+        heads[hash] = (int32_t)aPosition;
+    };
+    size_t position = 0;
+    while(position < aSize)
+    {
+        size_t bestLength = 0, bestDistance = 0;
+        if(position + kMinMatch <= aSize)
+        {
+            const size_t maxLength = std::min(kMaxMatch, aSize - position);
+            int32_t candidate = heads[hash3(someBytes + position)];
+            for(int chain = 0; chain < kMaxChainLength && candidate >= 0 && position - candidate <= kWindow; chain++)
+            {
+                size_t length = 0;
+                while(length < maxLength && someBytes[candidate + length] == someBytes[position + length])
+                    ++length;
+                if(length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = position - candidate;
+                    if(length == maxLength)
+                        break;
+                }
+                int32_t next = previous[candidate & (kWindow - 1)];
+                if(next >= candidate)
+                    break; // The slot was reused by a newer position
+                candidate = next;
+            }
+        }
+        if(bestLength >= kMinMatch)
+        {
+            writeMatch(writer, bestLength, bestDistance);
+            for(size_t end = position + bestLength; position < end; position++)
+            {
+                if(position + kMinMatch <= aSize)
+                    insert(position);
+            }
+        }
+        else
+        {
+            writeLiteral(writer, someBytes[position]);
+            if(position + kMinMatch <= aSize)
+                insert(position);
+            ++position;
+        }
+    }
+    writeLiteral(writer, 256);
+    writer.finish();
+    const uint32_t checksum = adler32(someBytes, aSize);
+    for(int shift = 24; shift >= 0; shift -= 8)
+        outBytes.push_back((uint8_t)(checksum >> shift));
+}
+
+static std::array<uint32_t, 256> makeCrcTable()
+{
+    std::array<uint32_t, 256> result;
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t value = i;
+        for(int bit = 0; bit < 8; bit++)
+            value = value & 1 ? 0xedb88320u ^ (value >> 1) : value >> 1;
+        result[i] = value;
+    }
+    return result;
+}
+
+static uint32_t crc32(const uint8_t* someBytes, size_t aSize)
+{
+    // Built once, safely even with several encoding threads
+    static const std::array<uint32_t, 256> ourTable = makeCrcTable();
+    uint32_t crc = 0xffffffffu;
+    for(size_t i = 0; i < aSize; i++)
+        crc = ourTable[(crc ^ someBytes[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+static void writeBigEndian(uint32_t aValue, std::vector<uint8_t>& outBytes)
+{
+    for(int shift = 24; shift >= 0; shift -= 8)
+        outBytes.push_back((uint8_t)(aValue >> shift));
+}
+
+static void writeChunk(const char* aType, const std::vector<uint8_t>& someData, std::vector<uint8_t>& outBytes)
+{
+    writeBigEndian((uint32_t)someData.size(), outBytes);
+    const size_t start = outBytes.size();
+    outBytes.insert(outBytes.end(), aType, aType + 4);
+    outBytes.insert(outBytes.end(), someData.begin(), someData.end());
+    writeBigEndian(crc32(&outBytes[start], outBytes.size() - start), outBytes);
+}
+
+void encodePng(const uint8_t* somePixels, unsigned aWidth, unsigned aHeight, int aChannels, std::vector<uint8_t>& outBytes)
+{
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    static const uint8_t kColourTypes[5] = { 0, 0, 4, 2, 6 };
+    outBytes.insert(outBytes.end(), kSignature, kSignature + sizeof(kSignature));
+    std::vector<uint8_t> header;
+    writeBigEndian(aWidth, header);
+    writeBigEndian(aHeight, header);
+    header.push_back(8);
+    header.push_back(kColourTypes[aChannels]);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    writeChunk("IHDR", header, outBytes);
+    // Every row unfiltered, repeated rows still become long matches one row back
+    const size_t rowBytes = (size_t)aWidth * aChannels;
+    std::vector<uint8_t> rows;
+    rows.reserve((rowBytes + 1) * aHeight);
+    for(unsigned y = 0; y < aHeight; y++)
+    {
+        rows.push_back(0);
+        rows.insert(rows.end(), somePixels + y * rowBytes, somePixels + (y + 1) * rowBytes);
+    }
+    std::vector<uint8_t> data;
+    deflateZlib(rows.data(), rows.size(), data);
+    writeChunk("IDAT", data, outBytes);
+    writeChunk("IEND", std::vector<uint8_t>(), outBytes);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Encode 8 bit pixels as PNG in memory, rows one after another without padding.
+/// Deflate uses greedy matching with the fixed Huffman codes, little code for the flat images this app makes.
+/// </summary>
+/// <param name="aChannels">1 for grey, 3 for RGB, 4 for RGBA</param>
+void encodePng(const uint8_t* somePixels, unsigned aWidth, unsigned aHeight, int aChannels, std::vector<uint8_t>& outBytes);
+
+/// <summary>
+/// zlib stream of someBytes, also the body of a PNG's image data
+/// </summary>
+void deflateZlib(const uint8_t* someBytes, size_t aSize, std::vector<uint8_t>& outBytes);
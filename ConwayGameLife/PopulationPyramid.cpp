@@ -0,0 +1,22 @@
+#include "PopulationPyramid.h"
+#include <algorithm>
+
+void PopulationPyramid::resize(int aSide)
+{
+    myLevels.assign(1, std::vector<uint32_t>());
+    mySides.assign(1, aSide);
+    for(int side = aSide; side > 1; )
+    {
+        side = (side + 1) / 2;
+        mySides.push_back(side);
+        myLevels.push_back(std::vector<uint32_t>((size_t)side * side, 0));
+    }
+    std::fill(myDensity, myDensity + kNumDensityBins, 0);
+}
+
+void PopulationPyramid::clear()
+{
+    for(auto& level : myLevels)
+        std::fill(level.begin(), level.end(), 0);
+    std::fill(myDensity, myDensity + kNumDensityBins, 0);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "LifeStats.h"
+
+/// <summary>
+/// Mip pyramid of live cell counts, level L counts blocks of 2^L x 2^L cells, up to one block for the world.
+/// Kept up to date cell by cell so zoomed out views never walk the live tiles.
+/// </summary>
+class PopulationPyramid
+{
+public:
+    /// <summary>
+    /// Change the world side, every count drops to 0
+    /// </summary>
+    void resize(int aSide);
+    void clear();
+
+    /// <summary>
+    /// Count a birth (+1) or a death (-1), cells from (0, 0) to (side - 1, side - 1)
+    /// </summary>
+    void add(int x, int y, int aDelta)
+    {
+        for(int level = 1; level < (int)myLevels.size(); level++)
+        {
+            uint32_t& count = myLevels[level][(y >> level) * mySides[level] + (x >> level)];
+            if(kDensityLevel == level)
+                moveDensity(count, count + aDelta);
+            count += aDelta;
+        }
+    }
+
+    /// <summary>
+    /// Levels from 1 to getNumLevels() - 1 are stored
+    /// </summary>
+    int getNumLevels() const { return (int)myLevels.size(); }
+    int getLevelSide(int aLevel) const { return mySides[aLevel]; }
+    const uint32_t* getLevel(int aLevel) const { return myLevels[aLevel].data(); }
+
+    /// <summary>
+    /// Blocks of kDensityLevel by live cells, kNumDensityBins of them, see GenerationStats::density
+    /// </summary>
+    const uint32_t* getDensity() const { return myDensity; }
+
+private:
+    void moveDensity(uint32_t anOld, uint32_t aNew)
+    {
+        if(anOld)
+            myDensity[(anOld - 1) >> 3]--;
+        if(aNew)
+            myDensity[(aNew - 1) >> 3]++;
+    }
+
+    std::vector<std::vector<uint32_t>> myLevels;
+    std::vector<int> mySides;
+    uint32_t myDensity[kNumDensityBins] = {};
+};
@@ -0,0 +1,99 @@
+#include "SoupSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include "BatchGrid.h"
+#include "BitGrid.h"
+#include "Log.h"
+
+static const int kSoupSide = 16;
+static const int kBoardSide = 64;
+static const uint64_t kMaxGenerations = 1 << 15;
+// Soups a thread hands to the batch engine at once, lanes refill from them as boards settle
+static const uint64_t kSeedsPerRun = 1024;
+
+/// <summary>
+/// Fill the centre of the board with a 50% density soup derived from the seed only
+/// </summary>
+static void fillSoup(uint64_t aSeed, BitGrid& outGrid)
+{
+    std::mt19937_64 random(aSeed);
+    outGrid.clear();
+    const int origin = (kBoardSide - kSoupSide) / 2;
+    for(int y = 0; y < kSoupSide; y += 4)
+    {
+        uint64_t bits = random();
+        for(int i = 0; i < 4 * kSoupSide; i++)
+            outGrid.set(origin + i % kSoupSide, origin + y + i / kSoupSide, (bits >> i) & 1);
+    }
+}
+
+void runSoups(uint64_t aFirstSeed, uint64_t aCount, unsigned aNumThreads, SoupResult& outResult)
+{
+    if(0 == aNumThreads)
+        aNumThreads = 1;
+    std::vector<SoupResult> threadResults(aNumThreads);
+    std::vector<std::thread> threads;
+    for(unsigned t = 0; t < aNumThreads; t++)
+    {
+        // Interleaved runs of seeds balance the load without any shared counter
+        threads.emplace_back([t, aNumThreads, aFirstSeed, aCount, &threadResults]()
+        {
+            SoupResult& result = threadResults[t];
+            std::vector<BitGrid> soups;
+            std::vector<BatchResult> finals;
+            for(uint64_t first = t * kSeedsPerRun; first < aCount; first += aNumThreads * kSeedsPerRun)
+            {
+                soups.assign((size_t)std::min(kSeedsPerRun, aCount - first), BitGrid(kBoardSide, kBoardSide));
+                for(size_t i = 0; i < soups.size(); i++)
+                    fillSoup(aFirstSeed + first + i, soups[i]);
+                runBatch(soups, kMaxGenerations, finals);
+                for(auto& final : finals)
+                {
+                    if(!final.isStable)
+                        ++result.unstabilised;
+                    result.generations += final.generations;
+                    ++result.soups;
+                    takeCensus(final.board, result.census);
+                }
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    for(auto& result : threadResults)
+    {
+        outResult.soups += result.soups;
+        outResult.unstabilised += result.unstabilised;
+        outResult.generations += result.generations;
+        mergeCensus(result.census, outResult.census);
+    }
+}
+
+int runSoupSearch(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        LOG_INFO("usage: --soup-search <first seed> <count> [threads]\n");
+        return 1;
+    }
+    uint64_t firstSeed = strtoull(argv[0], nullptr, 10);
+    uint64_t count = strtoull(argv[1], nullptr, 10);
+    unsigned numThreads = argc > 2 ? (unsigned)atoi(argv[2]) : std::thread::hardware_concurrency();
+    if(0 == numThreads)
+        numThreads = 1;
+    auto start = std::chrono::steady_clock::now();
+    SoupResult result;
+    runSoups(firstSeed, count, numThreads, result);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("%llu soups in %.3f s on %u threads, %.1f soups/s, %.1f generations/soup, %llu unstabilised\n",
+           (unsigned long long)result.soups, seconds, numThreads, result.soups / seconds,
+           result.soups ? (double)result.generations / result.soups : 0.0,
+           (unsigned long long)result.unstabilised);
+    printCensus(result.census, 50);
+    return 0;
+}
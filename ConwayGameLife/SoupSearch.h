@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include "Census.h"
+
+/// <summary>
+/// Totals of a batch of soups
+/// </summary>
+struct SoupResult
+{
+    uint64_t soups = 0;
+    uint64_t unstabilised = 0; // Still changing after the generation limit
+    uint64_t generations = 0;
+    CensusTable census;
+};
+
+/// <summary>
+/// Run the seeds [aFirstSeed, aFirstSeed + aCount) to stabilisation and census what is left.
+/// Every thread owns its engine and table, the result only depends on the seed range.
+/// </summary>
+void runSoups(uint64_t aFirstSeed, uint64_t aCount, unsigned aNumThreads, SoupResult& outResult);
+
+/// <summary>
+/// Command line entry, "--soup-search <first seed> <count> [threads]"
+/// </summary>
+int runSoupSearch(int argc, char* argv[]);
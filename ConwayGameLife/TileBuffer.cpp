@@ -0,0 +1,171 @@
+#include "TileBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include "Changes.h"
+
+// Dirty slots this close together go up in one update, fewer calls for a few untouched vertices
+static const uint32_t kMergeGap = 64;
+// Holes a chunk may collect before its live quads are packed again
+static const size_t kMaxFreeSlots = 256;
+
+TileBuffer::TileBuffer(float aSpacing)
+    : mySpacing(aSpacing)
+{
+}
+
+void TileBuffer::reset(const TileSet& someTiles)
+{
+    myChunks.clear();
+    mySlots.clear();
+    mySlots.reserve(someTiles.size());
+    for(auto& tile : someTiles)
+        add(tile);
+}
+
+void TileBuffer::apply(const ChangeList& someChanges)
+{
+    // Deaths first so births can take over their slots
+    for(auto& tile : someChanges.deaths)
+        remove(tile);
+    for(auto& tile : someChanges.births)
+        add(tile);
+}
+
+void TileBuffer::add(const sf::Vector2i& aTile)
+{
+    const uint64_t key = getKey(aTile);
+    if(mySlots.count(key))
+        return;
+    std::unique_ptr<Chunk>& chunk = myChunks[getKey(getChunkOf(aTile))];
+    if(!chunk)
+        chunk.reset(new Chunk());
+    uint32_t slot;
+    if(chunk->freeSlots.empty())
+    {
+        slot = (uint32_t)(chunk->vertices.size() / 4);
+        chunk->vertices.resize(chunk->vertices.size() + 4);
+    }
+    else
+    {
+        slot = chunk->freeSlots.back();
+        chunk->freeSlots.pop_back();
+    }
+    mySlots.emplace(key, slot);
+    writeQuad(*chunk, slot, aTile, true);
+}
+
+void TileBuffer::remove(const sf::Vector2i& aTile)
+{
+    auto it = mySlots.find(getKey(aTile));
+    if(mySlots.end() == it)
+        return;
+    auto chunkIt = myChunks.find(getKey(getChunkOf(aTile)));
+    Chunk& chunk = *chunkIt->second;
+    writeQuad(chunk, it->second, aTile, false);
+    chunk.freeSlots.push_back(it->second);
+    mySlots.erase(it);
+    // A chunk with nothing left goes away, a mostly empty one is packed so the GPU skips the holes
+    if(chunk.freeSlots.size() * 4 == chunk.vertices.size())
+        myChunks.erase(chunkIt);
+    else if(chunk.freeSlots.size() > kMaxFreeSlots && 2 * chunk.freeSlots.size() * 4 > chunk.vertices.size())
+        compact(chunk);
+}
+
+void TileBuffer::writeQuad(Chunk& ioChunk, uint32_t aSlot, const sf::Vector2i& aTile, bool isLive)
+{
+    sf::Vertex* quad = &ioChunk.vertices[(size_t)aSlot * 4];
+    const sf::Vector2f position = sf::Vector2f(aTile) * mySpacing;
+    const float size = isLive ? mySpacing : 0.f;
+    quad[0].position = position;
+    quad[1].position = position + sf::Vector2f(size, 0.f);
+    quad[2].position = position + sf::Vector2f(size, size);
+    quad[3].position = position + sf::Vector2f(0.f, size);
+    if(!ioChunk.isStale)
+        ioChunk.dirtySlots.push_back(aSlot);
+}
+
+void TileBuffer::compact(Chunk& ioChunk)
+{
+    std::vector<sf::Vertex> vertices;
+    vertices.reserve(ioChunk.vertices.size() - ioChunk.freeSlots.size() * 4);
+    for(size_t i = 0; i < ioChunk.vertices.size(); i += 4)
+    {
+        // Collapsed quads are the free slots
+        const sf::Vertex* quad = &ioChunk.vertices[i];
+        if(quad[0].position == quad[2].position)
+            continue;
+        const sf::Vector2i tile((int)std::floor(quad[0].position.x / mySpacing + 0.5f), (int)std::floor(quad[0].position.y / mySpacing + 0.5f));
+        mySlots[getKey(tile)] = (uint32_t)(vertices.size() / 4);
+        vertices.insert(vertices.end(), quad, quad + 4);
+    }
+    ioChunk.vertices.swap(vertices);
+    ioChunk.freeSlots.clear();
+    ioChunk.dirtySlots.clear();
+    ioChunk.isStale = true;
+}
+
+void TileBuffer::drawChunk(sf::RenderTarget& aTarget, Chunk& ioChunk)
+{
+    if(!sf::VertexBuffer::isAvailable())
+    {
+        ioChunk.dirtySlots.clear();
+        aTarget.draw(ioChunk.vertices.data(), ioChunk.vertices.size(), sf::Quads);
+        return;
+    }
+    sf::VertexBuffer& buffer = ioChunk.buffer;
+    if(ioChunk.isStale || buffer.getVertexCount() < ioChunk.vertices.size())
+    {
+        // Room to grow before the next full upload
+        if(buffer.getVertexCount() < ioChunk.vertices.size() && !buffer.create(std::max<size_t>(64, 2 * ioChunk.vertices.size())))
+            return;
+        buffer.update(ioChunk.vertices.data(), ioChunk.vertices.size(), 0);
+        ioChunk.isStale = false;
+        ioChunk.dirtySlots.clear();
+    }
+    else if(!ioChunk.dirtySlots.empty())
+    {
+        std::vector<uint32_t>& dirty = ioChunk.dirtySlots;
+        std::sort(dirty.begin(), dirty.end());
+        for(size_t i = 0; i < dirty.size();)
+        {
+            const uint32_t first = dirty[i];
+            uint32_t last = first;
+            while(++i < dirty.size() && dirty[i] <= last + kMergeGap)
+                last = dirty[i];
+            buffer.update(&ioChunk.vertices[(size_t)first * 4], (size_t)(last - first + 1) * 4, first * 4);
+        }
+        dirty.clear();
+    }
+    aTarget.draw(buffer, 0, ioChunk.vertices.size());
+}
+
+void TileBuffer::draw(sf::RenderTarget& aTarget)
+{
+    if(myChunks.empty())
+        return;
+    const sf::View& view = aTarget.getView();
+    const sf::Vector2f viewMin = view.getCenter() - view.getSize() / 2.f, viewMax = view.getCenter() + view.getSize() / 2.f;
+    const sf::Vector2i first = getChunkOf(sf::Vector2i((int)std::floor(viewMin.x / mySpacing), (int)std::floor(viewMin.y / mySpacing)));
+    const sf::Vector2i last = getChunkOf(sf::Vector2i((int)std::floor(viewMax.x / mySpacing), (int)std::floor(viewMax.y / mySpacing)));
+    // Look the visible chunks up when there are fewer of them than chunks in all, otherwise filter the lot
+    const int64_t numVisible = (int64_t)(last.x - first.x + 1) * (last.y - first.y + 1);
+    if(numVisible < (int64_t)myChunks.size())
+    {
+        for(int x = first.x; x <= last.x; x++)
+        {
+            for(int y = first.y; y <= last.y; y++)
+            {
+                auto it = myChunks.find(getKey(sf::Vector2i(x, y)));
+                if(myChunks.end() != it)
+                    drawChunk(aTarget, *it->second);
+            }
+        }
+        return;
+    }
+    for(auto& chunk : myChunks)
+    {
+        const int x = (int32_t)(chunk.first >> 32), y = (int32_t)(uint32_t)chunk.first;
+        if(x >= first.x && x <= last.x && y >= first.y && y <= last.y)
+            drawChunk(aTarget, *chunk.second);
+    }
+}
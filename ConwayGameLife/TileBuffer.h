@@ -0,0 +1,73 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "TileSet.h"
+
+struct ChangeList;
+
+/// <summary>
+/// Quads of the live tiles kept on the GPU between frames, in square chunks of tiles so a frame only draws
+/// the chunks the view touches. A generation's births and deaths rewrite only their own slots, a death leaves
+/// a collapsed quad that the next birth in its chunk reuses, and only the touched slot ranges are uploaded
+/// before drawing. Falls back to drawing from memory without vertex buffer support.
+/// </summary>
+class TileBuffer
+{
+public:
+    // Chunks are 2^kChunkShift tiles on a side
+    static const int kChunkShift = 6;
+
+    explicit TileBuffer(float aSpacing);
+
+    /// <summary>
+    /// Start over from a whole set, after edits too large to track or a jump of many generations
+    /// </summary>
+    void reset(const TileSet& someTiles);
+    void apply(const ChangeList& someChanges);
+    /// <summary>
+    /// Draw the chunks inside the target's view
+    /// </summary>
+    void draw(sf::RenderTarget& aTarget);
+
+    size_t getNumTiles() const { return mySlots.size(); }
+
+private:
+    struct Chunk
+    {
+        Chunk()
+            : buffer(sf::Quads, sf::VertexBuffer::Stream)
+        {
+        }
+
+        // Four vertices per slot, the copy uploads are made from
+        std::vector<sf::Vertex> vertices;
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint32_t> dirtySlots;
+        sf::VertexBuffer buffer;
+        // Everything has to go up, when new or when the buffer grew
+        bool isStale = true;
+    };
+
+    void add(const sf::Vector2i& aTile);
+    void remove(const sf::Vector2i& aTile);
+    void writeQuad(Chunk& ioChunk, uint32_t aSlot, const sf::Vector2i& aTile, bool isLive);
+    void compact(Chunk& ioChunk);
+    void drawChunk(sf::RenderTarget& aTarget, Chunk& ioChunk);
+
+    static uint64_t getKey(const sf::Vector2i& aTile)
+    {
+        return (uint64_t)(uint32_t)aTile.x << 32 | (uint32_t)aTile.y;
+    }
+    static sf::Vector2i getChunkOf(const sf::Vector2i& aTile)
+    {
+        return sf::Vector2i(aTile.x >> kChunkShift, aTile.y >> kChunkShift);
+    }
+
+    float mySpacing;
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> myChunks;
+    // Slot of each live tile within its chunk
+    std::unordered_map<uint64_t, uint32_t> mySlots;
+};
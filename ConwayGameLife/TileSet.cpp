@@ -0,0 +1,219 @@
+#include "TileSet.h"
+#include <vector>
+#include "Changes.h"
+#include "LifeStats.h"
+#include "PopulationPyramid.h"
+
+/// <summary>
+/// Pass through resource counting allocations and bytes
+/// </summary>
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    CountingResource(std::pmr::memory_resource* anUpstream, uint64_t& ioCount)
+        : myUpstream(anUpstream)
+        , myCount(ioCount)
+        , myBytes(0)
+    {
+    }
+
+    size_t getBytes() const { return myBytes; }
+
+private:
+    void* do_allocate(size_t aBytes, size_t anAlignment) override
+    {
+        ++myCount;
+        myBytes += aBytes;
+        return myUpstream->allocate(aBytes, anAlignment);
+    }
+
+    void do_deallocate(void* aPointer, size_t aBytes, size_t anAlignment) override
+    {
+        myUpstream->deallocate(aPointer, aBytes, anAlignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& anOther) const noexcept override
+    {
+        return this == &anOther;
+    }
+
+    std::pmr::memory_resource* myUpstream;
+    uint64_t& myCount;
+    size_t myBytes;
+};
+
+// First buffer of the boundary arena, an empty one would make the arena grow a node at a time
+static const size_t kInitialArenaBytes = 64 * 1024;
+
+/// <summary>
+/// Per thread node pool and the buffer the boundary arena starts from, grown to what the last generation needed
+/// </summary>
+struct TileMemory
+{
+    TileAllocationCounts counts;
+    CountingResource heap{ std::pmr::new_delete_resource(), counts.heap };
+    std::pmr::unsynchronized_pool_resource pool{ &heap };
+    CountingResource nodes{ &pool, counts.nodes };
+    std::vector<char> arenaBuffer = std::vector<char>(kInitialArenaBytes);
+};
+
+static TileMemory& getTileMemory()
+{
+    static thread_local TileMemory ourMemory;
+    return ourMemory;
+}
+
+std::pmr::memory_resource* getTileResource()
+{
+    return &getTileMemory().nodes;
+}
+
+TileAllocationCounts getTileAllocationCounts()
+{
+    return getTileMemory().counts;
+}
+
+/// <summary>
+/// Wrap the world up
+/// </summary>
+/// <param name="anInteger"></param>
+/// <param name="aModulo">The half length</param>
+/// <returns></returns>
+static int wrapInt(int anInteger, int aModulo)
+{
+    return (anInteger + 3 * aModulo) % (2 * aModulo) - aModulo;
+}
+
+int getNumOfLiveNeighbors(const sf::Vector2i& aTile, const TileSet& someTiles, int aHalfSide)
+{
+    int result = 0;
+    auto tempTile = aTile;
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y - 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y + 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+
+    tempTile.x = wrapInt(aTile.x - 1, aHalfSide);
+    tempTile.y = aTile.y;
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y - 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y + 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+
+    tempTile.x = wrapInt(aTile.x + 1, aHalfSide);
+    tempTile.y = aTile.y;
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y - 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    tempTile.y = wrapInt(aTile.y + 1, aHalfSide);
+    if(someTiles.end() != someTiles.find(tempTile)) ++result;
+    return result;
+}
+
+void setTileLiveness(const sf::Vector2i& aTile, TileSet& someTiles, bool isLive)
+{
+    if(isLive)
+    {
+        someTiles.insert(aTile);
+    }
+    else
+    {
+        const auto& it = someTiles.find(aTile);
+        if(someTiles.end() != it)
+            someTiles.erase(it);
+    }
+}
+
+void getProcessingTiles(const TileSet& someTiles, TileSet& someBoundaryTiles, int aHalfSide)
+{
+    for(auto& tile : someTiles)
+    {
+        auto tempTile = tile;
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y - 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y + 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+
+        tempTile.x = wrapInt(tile.x - 1, aHalfSide);
+        tempTile.y = tile.y;
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y - 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y + 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+
+        tempTile.y = tile.y;
+        tempTile.x = wrapInt(tile.x + 1, aHalfSide);
+        tempTile.y = tile.y;
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y - 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+        tempTile.y = wrapInt(tile.y + 1, aHalfSide);
+        someBoundaryTiles.insert(tempTile);
+    }
+}
+
+void processCore(TileSet& someLastLiveTiles, TileSet& someLiveTiles, GenerationStats* outStats, int aHalfSide,
+                 PopulationPyramid* ioPyramid, ChangeList* outChanges)
+{
+    std::swap(someLastLiveTiles, someLiveTiles);
+    someLiveTiles.clear();
+    // Boundary tiles live for one generation, in an arena over a reused buffer that is dropped all at once
+    TileMemory& memory = getTileMemory();
+    CountingResource arenaHeap(std::pmr::new_delete_resource(), memory.counts.heap);
+    std::pmr::monotonic_buffer_resource arena(memory.arenaBuffer.data(), memory.arenaBuffer.size(), &arenaHeap);
+    CountingResource arenaNodes(&arena, memory.counts.nodes);
+    TileAllocator<sf::Vector2i> arenaAllocator(&arenaNodes);
+    TileSet boundaryTiles(arenaAllocator);
+    getProcessingTiles(someLastLiveTiles, boundaryTiles, aHalfSide);
+    uint64_t survivors = 0;
+    if(outStats)
+        outStats->reset();
+    if(outChanges)
+        outChanges->clear();
+    // Based on someLastLiveTiles, modify someLiveTiles
+    for(auto& tile : boundaryTiles)
+    {
+        int num = getNumOfLiveNeighbors(tile, someLastLiveTiles, aHalfSide);
+        bool isLive = false, wasLive = false;
+        switch(num)
+        {
+        case 3:
+            isLive = true;
+            setTileLiveness(tile, someLiveTiles, true);
+            if(outStats || ioPyramid || outChanges)
+                wasLive = someLastLiveTiles.end() != someLastLiveTiles.find(tile);
+            break;
+        case 4:
+            isLive = wasLive = someLastLiveTiles.end() != someLastLiveTiles.find(tile);
+            setTileLiveness(tile, someLiveTiles, isLive);
+            break;
+        default:
+            setTileLiveness(tile, someLiveTiles, false);
+            if(ioPyramid || outChanges)
+                wasLive = someLastLiveTiles.end() != someLastLiveTiles.find(tile);
+            break;
+        }
+        if(isLive && wasLive)
+            ++survivors;
+        if(outStats && isLive)
+            outStats->include(tile.x, tile.y);
+        if(ioPyramid && isLive != wasLive)
+            ioPyramid->add(tile.x + aHalfSide, tile.y + aHalfSide, isLive ? 1 : -1);
+        if(outChanges && isLive != wasLive)
+            (isLive ? outChanges->births : outChanges->deaths).push_back(tile);
+    }
+    if(outStats)
+    {
+        // Every live tile of either generation is a boundary tile, so the counts fall out of the loop
+        outStats->population = someLiveTiles.size();
+        outStats->births = outStats->population - survivors;
+        outStats->deaths = someLastLiveTiles.size() - survivors;
+    }
+    boundaryTiles.clear();
+    if(arenaHeap.getBytes())
+        memory.arenaBuffer.resize(memory.arenaBuffer.size() + arenaHeap.getBytes());
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <memory_resource>
+#include <set>
+
+struct ChangeList;
+struct GenerationStats;
+class PopulationPyramid;
+
+struct TileComparator
+{
+    bool operator() (const sf::Vector2i& lhs, const sf::Vector2i& rhs) const
+    {
+        return lhs.x < rhs.x || lhs.x == rhs.x && lhs.y < rhs.y;
+    }
+};
+
+/// <summary>
+/// Node pool of the calling thread's tile sets. Cleared nodes go back to the pool instead of the heap,
+/// and sharing one pool keeps swapping two sets legal. Tile sets stay on the thread that made them.
+/// </summary>
+std::pmr::memory_resource* getTileResource();
+
+/// <summary>
+/// Polymorphic allocator defaulting to the tile pool, so a default constructed TileSet is pooled
+/// </summary>
+template<typename T>
+class TileAllocator : public std::pmr::polymorphic_allocator<T>
+{
+public:
+    TileAllocator() : std::pmr::polymorphic_allocator<T>(getTileResource()) {}
+    TileAllocator(std::pmr::memory_resource* aResource) : std::pmr::polymorphic_allocator<T>(aResource) {}
+    template<typename U>
+    TileAllocator(const TileAllocator<U>& anOther) : std::pmr::polymorphic_allocator<T>(anOther.resource()) {}
+
+    TileAllocator select_on_container_copy_construction() const { return TileAllocator(); }
+};
+
+typedef std::set<sf::Vector2i, TileComparator, TileAllocator<sf::Vector2i>> TileSet;
+
+/// <summary>
+/// Running totals of the calling thread, tile set nodes asked for and allocations that reached the heap
+/// </summary>
+struct TileAllocationCounts
+{
+    uint64_t nodes = 0;
+    uint64_t heap = 0;
+};
+TileAllocationCounts getTileAllocationCounts();
+
+// Half length of the shipped world, tiles range from -kSideLength to kSideLength - 1
+static const unsigned char kSideLength = 30;
+
+int getNumOfLiveNeighbors(const sf::Vector2i& aTile, const TileSet& someTiles, int aHalfSide = kSideLength);
+
+void setTileLiveness(const sf::Vector2i& aTile, TileSet& someTiles, bool isLive);
+
+/// <summary>
+/// Extend the boundary to include all potential live tiles
+/// </summary>
+void getProcessingTiles(const TileSet& someTiles, TileSet& someBoundaryTiles, int aHalfSide = kSideLength);
+
+/// <summary>
+/// Double buffering
+/// </summary>
+/// <param name="someLastLiveTiles"></param>
+/// <param name="someLiveTiles"></param>
+/// <param name="outStats">Optional, filled with population, births, deaths and bounding box of the new generation</param>
+/// <param name="aHalfSide">Half length of the torus</param>
+/// <param name="ioPyramid">Optional, births and deaths are counted into it</param>
+/// <param name="outChanges">Optional, cleared and filled with the tiles born and died, both in set order</param>
+void processCore(TileSet& someLastLiveTiles, TileSet& someLiveTiles, GenerationStats* outStats = nullptr, int aHalfSide = kSideLength,
+                 PopulationPyramid* ioPyramid = nullptr, ChangeList* outChanges = nullptr);
@@ -0,0 +1,139 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Viewer.h"
+#include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "Changes.h"
+#include "Log.h"
+#include "TileBuffer.h"
+#include "TileSet.h"
+
+// Records applied per frame when playing a file, a broadcast is applied as fast as it arrives
+static const int kRecordsPerFrame = 1;
+static const size_t kReceiveBytes = 64 * 1024;
+
+int runViewer(int argc, char* argv[])
+{
+    if(argc < 1)
+    {
+        LOG_INFO("usage: --view <host> <port> | --view <recording>\n");
+        return 1;
+    }
+    std::vector<uint8_t> bytes;
+    sf::TcpSocket socket;
+    const bool isLive = argc > 1;
+    bool isConnected = isLive;
+    if(isLive)
+    {
+        if(sf::Socket::Done != socket.connect(sf::IpAddress(argv[0]), (unsigned short)atoi(argv[1]), sf::seconds(5.f)))
+        {
+            LOG_ERROR("failed to connect to %s:%s\n", argv[0], argv[1]);
+            return 1;
+        }
+        socket.setBlocking(false);
+    }
+    else
+    {
+        FILE* file = fopen(argv[0], "rb");
+        if(nullptr == file)
+        {
+            LOG_ERROR("failed to open recording %s\n", argv[0]);
+            return 1;
+        }
+        char buffer[kReceiveBytes];
+        size_t count;
+        while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            bytes.insert(bytes.end(), buffer, buffer + count);
+        fclose(file);
+    }
+    const std::string kStrTitle = "Conway's Game of Life viewer";
+    sf::RenderWindow window(sf::VideoMode(800, 800), kStrTitle);
+    window.setFramerateLimit(60);
+    int halfSide = 0;
+    bool hasHeader = false, hasKeyframe = false;
+    size_t consumed = 0;
+    uint64_t generation = 0, bytesReceived = 0;
+    TileSet liveTiles;
+    TileBuffer tileBuffer(1.f);
+    ChangeList changes;
+    sf::Clock rateClock;
+    uint64_t bytesAtRate = 0;
+    float rate = 0.f;
+    while(window.isOpen())
+    {
+        sf::Event event;
+        while(window.pollEvent(event))
+        {
+            if(sf::Event::Closed == event.type || (sf::Event::KeyPressed == event.type && sf::Keyboard::Escape == event.key.code))
+                window.close();
+        }
+        if(isConnected)
+        {
+            char buffer[kReceiveBytes];
+            size_t received = 0;
+            sf::Socket::Status status;
+            while(sf::Socket::Done == (status = socket.receive(buffer, sizeof(buffer), received)))
+            {
+                bytes.insert(bytes.end(), buffer, buffer + received);
+                bytesReceived += received;
+            }
+            if(sf::Socket::Disconnected == status)
+            {
+                LOG_INFO("server closed the stream at generation %llu\n", (unsigned long long)generation);
+                isConnected = false;
+            }
+        }
+        const uint8_t* cursor = bytes.data() + consumed;
+        const uint8_t* end = bytes.data() + bytes.size();
+        if(!hasHeader && readStreamHeader(cursor, end, halfSide))
+        {
+            hasHeader = true;
+            sf::View view(sf::FloatRect(-(float)halfSide, -(float)halfSide, 2.f * halfSide, 2.f * halfSide));
+            window.setView(view);
+        }
+        uint64_t recordGeneration;
+        bool isKeyframe;
+        for(int i = 0; hasHeader && (isLive || i < kRecordsPerFrame)
+            && readStreamRecord(cursor, end, halfSide, recordGeneration, isKeyframe, changes); i++)
+        {
+            if(isKeyframe)
+            {
+                liveTiles.clear();
+                liveTiles.insert(changes.births.begin(), changes.births.end());
+                tileBuffer.reset(liveTiles);
+                hasKeyframe = true;
+            }
+            else if(hasKeyframe)
+            {
+                for(auto& tile : changes.deaths)
+                    liveTiles.erase(tile);
+                liveTiles.insert(changes.births.begin(), changes.births.end());
+                tileBuffer.apply(changes);
+            }
+            generation = recordGeneration;
+        }
+        consumed = cursor - bytes.data();
+        // Keep the buffer from growing with the whole stream
+        if(isLive && consumed > kReceiveBytes && consumed * 2 > bytes.size())
+        {
+            bytes.erase(bytes.begin(), bytes.begin() + consumed);
+            consumed = 0;
+        }
+        if(rateClock.getElapsedTime().asSeconds() >= 1.f)
+        {
+            rate = (bytesReceived - bytesAtRate) / 1024.f / rateClock.restart().asSeconds();
+            bytesAtRate = bytesReceived;
+        }
+        char title[128];
+        snprintf(title, sizeof(title), " (generation %llu, %llu cells, %.1f kB/s)", (unsigned long long)generation,
+                 (unsigned long long)liveTiles.size(), rate);
+        window.setTitle(kStrTitle + title);
+        window.clear();
+        tileBuffer.draw(window);
+        window.display();
+    }
+    return 0;
+}
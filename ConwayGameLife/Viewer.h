@@ -0,0 +1,6 @@
+#pragma once
+
+/// <summary>
+/// Command line entry, "--view <host> <port>" to watch a broadcast or "--view <recording>" to play a delta recording
+/// </summary>
+int runViewer(int argc, char* argv[]);
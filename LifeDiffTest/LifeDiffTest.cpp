@@ -0,0 +1,10 @@
+#include "DiffTest.h"
+
+/// <summary>
+/// The differential test on its own, "LifeDiffTest [cases] [generations] [seed]". It only links the engines,
+/// no SFML window or graphics, so it runs where there is no display.
+/// </summary>
+int main(int argc, char* argv[])
+{
+    return runDiffTest(argc - 1, argv + 1);
+}
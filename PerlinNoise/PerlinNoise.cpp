@@ -1,5 +1,6 @@
 #include <SFML/Graphics.hpp>
 #include <math.h>
+#include "Log.h"
 
 /// <summary>
 /// smoother
@@ -152,9 +153,7 @@ int main()
     sf::RenderWindow window(sf::VideoMode(ourWinHeight, ourWinWidth), "Perlin Noise");
     sf::VertexArray vertices(sf::Points, ourWinHeight * ourWinWidth);
     sf::Clock clock;
-    float lastFrameTime = 0.f;
     float currentTime = 0.f;
-    float deltaTime = 0.f;
     while(window.isOpen())
     {
         currentTime = clock.getElapsedTime().asSeconds();
@@ -181,9 +180,7 @@ int main()
         window.clear();
         window.draw(vertices);
         window.display();
-        lastFrameTime = clock.getElapsedTime().asSeconds();
-        deltaTime = lastFrameTime - currentTime;
-        printf("fps: %.3f\n", 1 / deltaTime);
+        LOG_DEBUG("fps: %.3f\n", 1 / (clock.getElapsedTime().asSeconds() - currentTime));
     }
     return 0;
 }
\ No newline at end of file